@@ -6,7 +6,10 @@
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
+#include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -32,6 +35,7 @@
 #define STA_BSY 0x80            /* Busy. */
 #define STA_DRDY 0x40           /* Device Ready. */
 #define STA_DRQ 0x08            /* Data Request. */
+#define STA_ERR 0x01            /* Error. */
 
 /* Control Register bits. */
 #define CTL_SRST 0x04           /* Software Reset. */
@@ -47,6 +51,46 @@
 #define CMD_IDENTIFY_DEVICE 0xec        /* IDENTIFY DEVICE. */
 #define CMD_READ_SECTOR_RETRY 0x20      /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30     /* WRITE SECTOR with retries. */
+#define CMD_READ_MULTIPLE 0xc4          /* READ MULTIPLE. */
+#define CMD_WRITE_MULTIPLE 0xc5         /* WRITE MULTIPLE. */
+#define CMD_SET_MULTIPLE_MODE 0xc6      /* SET MULTIPLE MODE. */
+#define CMD_READ_DMA 0xc8               /* READ DMA. */
+#define CMD_WRITE_DMA 0xca              /* WRITE DMA. */
+
+/* PCI configuration space access ports, used to find the
+   bus-master IDE controller (PIIX in QEMU and Bochs). */
+#define PCI_CONFIG_ADDR 0xcf8
+#define PCI_CONFIG_DATA 0xcfc
+
+/* Bus-master IDE register port addresses, for a channel whose
+   bus-master registers start at BM_BASE. */
+#define reg_bm_command(CHANNEL) ((CHANNEL)->bm_base + 0) /* Command. */
+#define reg_bm_status(CHANNEL) ((CHANNEL)->bm_base + 2)  /* Status. */
+#define reg_bm_prdt(CHANNEL) ((CHANNEL)->bm_base + 4)    /* PRD table. */
+
+/* Bus-master Command Register bits. */
+#define BM_START 0x01           /* Start/stop transfer. */
+#define BM_READ 0x08            /* 1=Device to memory, 0=memory to device. */
+
+/* Bus-master Status Register bits. */
+#define BM_STA_ERR 0x02         /* Error (write 1 to clear). */
+#define BM_STA_INTR 0x04        /* Interrupt (write 1 to clear). */
+
+/* Physical Region Descriptor: one physically contiguous piece
+   of a DMA buffer.  A PRD table is an array of these, the last
+   one marked with PRD_EOT, that must not cross a 64 kB
+   boundary; we keep each channel's table in its own page. */
+struct prd {
+	uint32_t addr;              /* Physical address of the piece. */
+	uint16_t size;              /* Size in bytes, 0 meaning 64 kB. */
+	uint16_t flags;             /* PRD_EOT on the last entry. */
+};
+#define PRD_EOT 0x8000
+#define PRD_CNT (PGSIZE / sizeof (struct prd))
+
+/* Whether to use bus-master DMA when the controller supports it.
+   Cleared by the -no-dma kernel option. */
+bool disk_dma = true;
 
 /* An ATA device. */
 struct disk {
@@ -56,9 +100,20 @@ struct disk {
 
 	bool is_ata;                /* 1=This device is an ATA disk. */
 	disk_sector_t capacity;     /* Capacity in sectors (if is_ata). */
+	size_t multiple;            /* Sectors per DRQ block for READ/WRITE
+	                               MULTIPLE, or 0 if not enabled. */
+	bool dma;                   /* Transfer by bus-master DMA? */
 
 	long long read_cnt;         /* Number of sectors read. */
 	long long write_cnt;        /* Number of sectors written. */
+	long long command_cnt;      /* Number of read/write commands. */
+	long long dma_cnt;          /* Sectors transferred by DMA. */
+	long long pio_cnt;          /* Sectors transferred by PIO. */
+	uint64_t busy_cycles;       /* TSC cycles spent in read/write. */
+
+	disk_sector_t head;         /* Sector after the last command. */
+	long long seek_sectors;     /* Sum of distances between commands. */
+	long long merge_cnt;        /* Requests merged into another's command. */
 };
 
 /* An ATA channel (aka controller).
@@ -67,12 +122,30 @@ struct channel {
 	char name[8];               /* Name, e.g. "hd0". */
 	uint16_t reg_base;          /* Base I/O port. */
 	uint8_t irq;                /* Interrupt in use. */
+	uint16_t bm_base;           /* Bus-master I/O port, 0 if none. */
+	struct prd *prdt;           /* PRD table, in a kernel-pool page. */
 
-	struct lock lock;           /* Must acquire to access the controller. */
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
 	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
 
+	/* Request queue.  Only touched with interrupts off, since the
+	   interrupt handler completes requests and starts the next. */
+	struct list queue;          /* Waiting requests, by position. */
+	uint64_t head;              /* Position after the last command. */
+
+	/* The command in flight, if ACTIVE is not empty. */
+	struct list active;         /* Requests merged into it, in order. */
+	struct disk *active_disk;   /* Disk it is for. */
+	disk_sector_t active_sec;   /* First sector. */
+	size_t active_cnt;          /* Number of sectors. */
+	bool active_write;          /* Writing to the disk? */
+	bool active_dma;            /* Transferring by DMA? */
+	uint64_t active_start;      /* TSC when it was issued. */
+	size_t pio_done;            /* Sectors moved so far by PIO. */
+	struct list_elem *pio_req;  /* Request holding the next PIO sector. */
+	size_t pio_ofs;             /* Index of that sector within PIO_REQ. */
+
 	struct disk devices[2];     /* The devices on this channel. */
 };
 
@@ -84,7 +157,21 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static bool set_multiple_mode (struct disk *, size_t cnt);
+static uint16_t find_bus_master (void);
+
+static void disk_transfer (struct disk *, disk_sector_t, size_t cnt,
+		void *, bool write);
+static void channel_dispatch (struct channel *);
+static void channel_interrupt (struct channel *);
+static void channel_complete (struct channel *);
+static bool dma_start (struct channel *);
+static bool dma_finish (struct channel *);
+static void pio_start (struct channel *);
+static void pio_input_block (struct channel *);
+static void pio_output_block (struct channel *);
+
+static void select_sectors (struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -96,9 +183,19 @@ static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
 
+/* TSC cycles per timer tick, measured while the channels reset, for
+   converting busy cycles into throughput. */
+static uint64_t tsc_per_tick;
+
+/* TSC when disk_init() started, for channel utilization. */
+static uint64_t init_tsc;
+
 /* Initialize the disk subsystem and detect disks. */
 void
 disk_init (void) {
+	int64_t start_ticks = timer_ticks ();
+	uint64_t start_tsc = init_tsc = rdtsc ();
+	uint16_t bm_base = disk_dma ? find_bus_master () : 0;
 	size_t chan_no;
 
 	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
@@ -119,9 +216,18 @@ disk_init (void) {
 			default:
 				NOT_REACHED ();
 		}
-		lock_init (&c->lock);
+		c->bm_base = 0;
+		c->prdt = NULL;
+		if (bm_base != 0) {
+			c->prdt = palloc_get_page (0);
+			if (c->prdt != NULL)
+				c->bm_base = bm_base + chan_no * 8;
+		}
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
+		list_init (&c->queue);
+		list_init (&c->active);
+		c->head = 0;
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -132,8 +238,15 @@ disk_init (void) {
 
 			d->is_ata = false;
 			d->capacity = 0;
+			d->multiple = 0;
+			d->dma = false;
 
 			d->read_cnt = d->write_cnt = 0;
+			d->command_cnt = 0;
+			d->dma_cnt = d->pio_cnt = 0;
+			d->head = 0;
+			d->seek_sectors = d->merge_cnt = 0;
+			d->busy_cycles = 0;
 		}
 
 		/* Register interrupt handler. */
@@ -152,6 +265,11 @@ disk_init (void) {
 				identify_ata_device (&c->devices[dev_no]);
 	}
 
+	/* Resetting the channels sleeps for a few hundred
+	   milliseconds, long enough to time the TSC against. */
+	if (timer_elapsed (start_ticks) > 0)
+		tsc_per_tick = (rdtsc () - start_tsc) / timer_elapsed (start_ticks);
+
 	/* DO NOT MODIFY BELOW LINES. */
 	register_disk_inspect_intr ();
 }
@@ -159,17 +277,43 @@ disk_init (void) {
 /* Prints disk statistics. */
 void
 disk_print_stats (void) {
+	uint64_t elapsed = rdtsc () - init_tsc;
 	int chan_no;
 
 	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
+		struct channel *c = &channels[chan_no];
+		uint64_t busy = 0;
 		int dev_no;
 
 		for (dev_no = 0; dev_no < 2; dev_no++) {
 			struct disk *d = disk_get (chan_no, dev_no);
-			if (d != NULL && d->is_ata)
-				printf ("%s: %lld reads, %lld writes\n",
-						d->name, d->read_cnt, d->write_cnt);
+			if (d != NULL && d->is_ata) {
+				long long sectors = d->read_cnt + d->write_cnt;
+				uint64_t kbps = 0;
+
+				if (d->busy_cycles != 0 && tsc_per_tick != 0)
+					kbps = sectors * DISK_SECTOR_SIZE / 1024 * tsc_per_tick
+						* TIMER_FREQ / d->busy_cycles;
+				printf ("%s: %lld reads, %lld writes, %lld commands, "
+						"%llu kB/s while busy\n",
+						d->name, d->read_cnt, d->write_cnt, d->command_cnt,
+						(unsigned long long) kbps);
+				printf ("%s: %lld sectors by DMA, %lld by PIO\n",
+						d->name, d->dma_cnt, d->pio_cnt);
+				printf ("%s: %lld requests merged, average seek %lld sectors\n",
+						d->name, d->merge_cnt, d->command_cnt != 0
+						? d->seek_sectors / d->command_cnt : 0);
+				busy += d->busy_cycles;
+			}
 		}
+
+		/* A channel runs one command at a time, so it is busy for
+		   exactly the time its disks are. */
+		if (busy != 0 && tsc_per_tick != 0)
+			printf ("%s: busy %llu of %llu ticks (%llu%%)\n", c->name,
+					(unsigned long long) (busy / tsc_per_tick),
+					(unsigned long long) (elapsed / tsc_per_tick),
+					(unsigned long long) (busy * 100 / elapsed));
 	}
 }
 
@@ -194,6 +338,23 @@ disk_get (int chan_no, int dev_no) {
 	return NULL;
 }
 
+/* Stores into *COMMAND_CNT the number of read/write commands
+   issued to disk D so far, and into *SEEK_SECTORS the sum of the
+   distances, in sectors, from the end of each command to the
+   start of the next.  Their quotient is the average seek. */
+void
+disk_seek_stats (struct disk *d, long long *command_cnt,
+		long long *seek_sectors) {
+	enum intr_level old_level;
+
+	ASSERT (d != NULL);
+
+	old_level = intr_disable ();
+	*command_cnt = d->command_cnt;
+	*seek_sectors = d->seek_sectors;
+	intr_set_level (old_level);
+}
+
 /* Returns the size of disk D, measured in DISK_SECTOR_SIZE-byte
    sectors. */
 disk_sector_t
@@ -209,21 +370,7 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
-	struct channel *c;
-
-	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
-
-	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
-	lock_release (&c->lock);
+	disk_read_multi (d, sec_no, 1, buffer);
 }
 
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
@@ -233,23 +380,375 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
    per-disk locking is unneeded. */
 void
 disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	disk_write_multi (d, sec_no, 1, buffer);
+}
+
+/* Reads CNT contiguous sectors starting at SEC_NO from disk D
+   into BUFFER, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes.  CNT must be between 1 and DISK_MULTI_MAX.  The sectors
+   arrive in a single command, possibly together with other
+   threads' requests for the sectors around them.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_multi (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		void *buffer) {
+	disk_transfer (d, sec_no, cnt, buffer, false);
+}
+
+/* Writes CNT contiguous sectors starting at SEC_NO to disk D
+   from BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes,
+   as a single command.  Returns after the disk has acknowledged
+   receiving the last sector.  CNT must be between 1 and
+   DISK_MULTI_MAX.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write_multi (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		const void *buffer) {
+	disk_transfer (d, sec_no, cnt, (void *) buffer, true);
+}
+
+/* Completion callback for disk_transfer(). */
+static void
+wake_submitter (struct disk_request *r) {
+	sema_up (r->aux);
+}
+
+/* Submits a request for CNT sectors at SEC_NO on disk D and
+   sleeps until it completes. */
+static void
+disk_transfer (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		void *buffer, bool write) {
+	struct disk_request r;
+	struct semaphore done;
+
+	sema_init (&done, 0);
+	r.disk = d;
+	r.sec_no = sec_no;
+	r.cnt = cnt;
+	r.buffer = buffer;
+	r.write = write;
+	r.done = wake_submitter;
+	r.aux = &done;
+	disk_submit (&r);
+	sema_down (&done);
+}
+
+/* Returns R's position for the elevator: disks on a channel are
+   laid end to end, device 0 first. */
+static uint64_t
+request_pos (const struct disk_request *r) {
+	return ((uint64_t) r->disk->dev_no << 32) | r->sec_no;
+}
+
+/* Orders requests by position.  Requests at the same position
+   stay in submission order. */
+static bool
+request_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct disk_request *a = list_entry (a_, struct disk_request, elem);
+	const struct disk_request *b = list_entry (b_, struct disk_request, elem);
+
+	return request_pos (a) < request_pos (b);
+}
+
+/* Queues request R on its disk's channel and returns at once;
+   R->done is called, from the disk interrupt handler, once the
+   transfer has finished.  R must stay valid until then.
+   Requests that are queued at the same time may be serviced in
+   any order.  May be called from an interrupt handler. */
+void
+disk_submit (struct disk_request *r) {
 	struct channel *c;
+	enum intr_level old_level;
+
+	ASSERT (r != NULL);
+	ASSERT (r->disk != NULL && r->disk->is_ata);
+	ASSERT (r->buffer != NULL);
+	ASSERT (r->cnt >= 1 && r->cnt <= DISK_MULTI_MAX);
+	ASSERT (r->done != NULL);
+
+	c = r->disk->channel;
+	old_level = intr_disable ();
+	list_insert_ordered (&c->queue, &r->elem, request_less, NULL);
+	if (list_empty (&c->active))
+		channel_dispatch (c);
+	intr_set_level (old_level);
+}
 
-	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
+/* If channel C is idle, picks its next command with the C-LOOK
+   elevator and issues it: the first request at or past where the
+   last command ended, or, if there is none, the lowest one, so
+   that the heads only ever sweep upward.  Requests that continue
+   it on the same disk, in the same direction, are merged into the
+   same command, up to DISK_MULTI_MAX sectors. */
+static void
+channel_dispatch (struct channel *c) {
+	struct disk_request *first = NULL;
+	struct list_elem *e, *next;
+	struct disk *d;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!list_empty (&c->active) || list_empty (&c->queue))
+		return;
+
+	for (e = list_begin (&c->queue); e != list_end (&c->queue);
+			e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		if (request_pos (r) >= c->head) {
+			first = r;
+			break;
+		}
+	}
+	if (first == NULL)
+		first = list_entry (list_front (&c->queue), struct disk_request, elem);
+
+	d = first->disk;
+	c->active_disk = d;
+	c->active_sec = first->sec_no;
+	c->active_cnt = 0;
+	c->active_write = first->write;
+	for (e = &first->elem; e != list_end (&c->queue); e = next) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+
+		next = list_next (e);
+		if (r->disk != d || r->write != c->active_write
+				|| r->sec_no != c->active_sec + c->active_cnt
+				|| c->active_cnt + r->cnt > DISK_MULTI_MAX)
+			break;
+		list_remove (e);
+		list_push_back (&c->active, e);
+		c->active_cnt += r->cnt;
+	}
+	d->merge_cnt += list_size (&c->active) - 1;
+
+	d->seek_sectors += c->active_sec >= d->head
+		? c->active_sec - d->head : d->head - c->active_sec;
+	d->head = c->active_sec + c->active_cnt;
+	c->head = request_pos (first) + c->active_cnt;
+	d->command_cnt++;
+
+	c->active_start = rdtsc ();
+	c->active_dma = dma_start (c);
+	if (!c->active_dma)
+		pio_start (c);
+}
+
+/* Handles an interrupt for channel C's command in flight. */
+static void
+channel_interrupt (struct channel *c) {
+	struct disk *d = c->active_disk;
+
+	if (c->active_dma) {
+		if (!dma_finish (c)) {
+			/* Do the same command over by PIO. */
+			c->active_dma = false;
+			pio_start (c);
+			return;
+		}
+	} else {
+		/* The drive raises one interrupt per block it has ready
+		   for us, or has taken from us. */
+		inb (reg_status (c));               /* Acknowledge interrupt. */
+		if (!c->active_write) {
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk read failed, sector=%"PRDSNu,
+						d->name, c->active_sec + (disk_sector_t) c->pio_done);
+			pio_input_block (c);
+		}
+		if (c->pio_done < c->active_cnt) {
+			if (c->active_write)
+				pio_output_block (c);
+			return;
+		}
+	}
+	channel_complete (c);
+}
+
+/* Finishes channel C's command in flight: accounts for it,
+   issues the next one so that the disk does not sit idle, and
+   then calls the completion callbacks of the requests it
+   carried. */
+static void
+channel_complete (struct channel *c) {
+	struct disk *d = c->active_disk;
+	struct list done;
+
+	d->busy_cycles += rdtsc () - c->active_start;
+	if (c->active_write)
+		d->write_cnt += c->active_cnt;
+	else
+		d->read_cnt += c->active_cnt;
+	if (c->active_dma)
+		d->dma_cnt += c->active_cnt;
+	else
+		d->pio_cnt += c->active_cnt;
+
+	list_init (&done);
+	while (!list_empty (&c->active))
+		list_push_back (&done, list_pop_front (&c->active));
+	channel_dispatch (c);
+
+	while (!list_empty (&done)) {
+		struct disk_request *r = list_entry (list_pop_front (&done),
+				struct disk_request, elem);
+		r->done (r);
+	}
+}
+
+/* Starts channel C's command in flight as a bus-master DMA
+   transfer, so that the CPU is free until the completion
+   interrupt.  The PRD table points straight into the buffers of
+   the requests merged into the command.  Returns false, having
+   started nothing, if the disk cannot do DMA or some buffer
+   cannot be described by the PRD table; the caller then falls
+   back to PIO. */
+static bool
+dma_start (struct channel *c) {
+	struct disk *d = c->active_disk;
+	uint8_t direction = c->active_write ? 0 : BM_READ;
+	size_t prd_cnt = 0;
+	struct list_elem *e;
+
+	if (!d->dma)
+		return false;
+
+	/* Describe each buffer one page at a time: the kernel pool is
+	   directly mapped, but a page never crosses a 64 kB boundary,
+	   which a longer run could. */
+	for (e = list_begin (&c->active); e != list_end (&c->active);
+			e = list_next (e)) {
+		struct disk_request *r = list_entry (e, struct disk_request, elem);
+		uint8_t *p = r->buffer;
+		size_t left = r->cnt * DISK_SECTOR_SIZE;
+
+		if (!is_kernel_vaddr (p) || ((uintptr_t) p & 1))
+			return false;
+		while (left > 0) {
+			size_t chunk = PGSIZE - pg_ofs (p);
+			uint64_t pa = vtop (p);
+
+			if (chunk > left)
+				chunk = left;
+			if (prd_cnt == PRD_CNT || pa + chunk > UINT32_MAX)
+				return false;
+			c->prdt[prd_cnt].addr = pa;
+			c->prdt[prd_cnt].size = chunk;
+			c->prdt[prd_cnt].flags = 0;
+			prd_cnt++;
+			p += chunk;
+			left -= chunk;
+		}
+	}
+	c->prdt[prd_cnt - 1].flags = PRD_EOT;
+
+	/* Program the bus master, then the disk, then start. */
+	outl (reg_bm_prdt (c), vtop (c->prdt));
+	outb (reg_bm_command (c), direction);
+	outb (reg_bm_status (c),
+			inb (reg_bm_status (c)) | BM_STA_ERR | BM_STA_INTR);
+	select_sectors (d, c->active_sec, c->active_cnt);
+	issue_pio_command (c, c->active_write ? CMD_WRITE_DMA : CMD_READ_DMA);
+	outb (reg_bm_command (c), direction | BM_START);
+	return true;
+}
+
+/* Stops the bus master of channel C after its completion
+   interrupt and acknowledges the interrupt.  Returns true if the
+   transfer succeeded.  Otherwise, turns DMA off for the disk and
+   returns false. */
+static bool
+dma_finish (struct channel *c) {
+	struct disk *d = c->active_disk;
+	uint8_t bm_status;
+
+	outb (reg_bm_command (c), c->active_write ? 0 : BM_READ);
+	bm_status = inb (reg_bm_status (c));
+	outb (reg_bm_status (c), bm_status | BM_STA_ERR | BM_STA_INTR);
+	if ((inb (reg_status (c)) & STA_ERR) || (bm_status & BM_STA_ERR)) {
+		printf ("%s: DMA transfer failed, sector=%"PRDSNu", using PIO\n",
+				d->name, c->active_sec);
+		d->dma = false;
+		return false;
+	}
+	return true;
+}
+
+/* Starts channel C's command in flight in PIO mode.  If the disk
+   supports it, the command is READ or WRITE MULTIPLE, which
+   transfers a block of D->multiple sectors per interrupt;
+   otherwise it is READ or WRITE SECTOR, with one interrupt per
+   sector.  For a write, the first block goes out right away. */
+static void
+pio_start (struct channel *c) {
+	struct disk *d = c->active_disk;
+
+	c->pio_done = 0;
+	c->pio_req = list_begin (&c->active);
+	c->pio_ofs = 0;
+	select_sectors (d, c->active_sec, c->active_cnt);
+	if (c->active_write) {
+		issue_pio_command (c, d->multiple != 0
+				? CMD_WRITE_MULTIPLE : CMD_WRITE_SECTOR_RETRY);
+		pio_output_block (c);
+	} else
+		issue_pio_command (c, d->multiple != 0
+				? CMD_READ_MULTIPLE : CMD_READ_SECTOR_RETRY);
+}
+
+/* Returns the number of sectors in the next PIO block of channel
+   C's command in flight. */
+static size_t
+pio_block_size (const struct channel *c) {
+	size_t block = c->active_disk->multiple != 0
+		? c->active_disk->multiple : 1;
+	size_t left = c->active_cnt - c->pio_done;
+
+	return left < block ? left : block;
+}
+
+/* Returns the buffer for the next PIO sector of channel C's
+   command in flight, which may belong to any of the requests
+   merged into it, and advances past it. */
+static void *
+pio_next_sector (struct channel *c) {
+	struct disk_request *r = list_entry (c->pio_req, struct disk_request, elem);
+	uint8_t *sector = (uint8_t *) r->buffer + c->pio_ofs * DISK_SECTOR_SIZE;
+
+	if (++c->pio_ofs == r->cnt) {
+		c->pio_req = list_next (c->pio_req);
+		c->pio_ofs = 0;
+	}
+	c->pio_done++;
+	return sector;
+}
+
+/* Reads the block of sectors that the disk on channel C has
+   ready. */
+static void
+pio_input_block (struct channel *c) {
+	size_t n = pio_block_size (c);
+
+	while (n-- > 0)
+		input_sector (c, pio_next_sector (c));
+}
+
+/* Writes the next block of sectors to the disk on channel C,
+   once it is ready to take them. */
+static void
+pio_output_block (struct channel *c) {
+	struct disk *d = c->active_disk;
+	size_t n = pio_block_size (c);
 
-	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
 	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
-	lock_release (&c->lock);
+		PANIC ("%s: disk write failed, sector=%"PRDSNu,
+				d->name, c->active_sec + (disk_sector_t) c->pio_done);
+	while (n-- > 0)
+		output_sector (c, pio_next_sector (c));
 }
-
+
 /* Disk detection and identification. */
 
 static void print_ata_string (char *string, size_t size);
@@ -364,6 +863,15 @@ identify_ata_device (struct disk *d) {
 	/* Calculate capacity. */
 	d->capacity = id[60] | ((uint32_t) id[61] << 16);
 
+	/* Enable READ/WRITE MULTIPLE with the largest block the disk
+	   supports, given in the low byte of word 47. */
+	if ((id[47] & 0xff) != 0 && set_multiple_mode (d, id[47] & 0xff))
+		d->multiple = id[47] & 0xff;
+
+	/* Use DMA if the channel has a bus master and the disk
+	   reports DMA support in word 49. */
+	d->dma = d->channel->bm_base != 0 && (id[49] & (1 << 8)) != 0;
+
 	/* Print identification message. */
 	printf ("%s: detected %'"PRDSNu" sector (", d->name, d->capacity);
 	if (d->capacity > 1024 / DISK_SECTOR_SIZE * 1024 * 1024)
@@ -382,6 +890,72 @@ identify_ata_device (struct disk *d) {
 	printf ("\"\n");
 }
 
+/* Sends a SET MULTIPLE MODE command to disk D, so that READ and
+   WRITE MULTIPLE transfer CNT sectors per interrupt.  Returns true
+   if the disk accepted it. */
+static bool
+set_multiple_mode (struct disk *d, size_t cnt) {
+	struct channel *c = d->channel;
+
+	select_device_wait (d);
+	outb (reg_nsect (c), cnt);
+	issue_pio_command (c, CMD_SET_MULTIPLE_MODE);
+	sema_down (&c->completion_wait);
+	wait_while_busy (d);
+	return (inb (reg_alt_status (c)) & STA_ERR) == 0;
+}
+
+/* Reads 32-bit register REG from the configuration space of PCI
+   function FUNC of device DEV on bus 0. */
+static uint32_t
+pci_read_config (int dev, int func, int reg) {
+	outl (PCI_CONFIG_ADDR, 0x80000000 | (dev << 11) | (func << 8) | reg);
+	return inl (PCI_CONFIG_DATA);
+}
+
+/* Writes VALUE to 32-bit register REG of PCI function FUNC of
+   device DEV on bus 0. */
+static void
+pci_write_config (int dev, int func, int reg, uint32_t value) {
+	outl (PCI_CONFIG_ADDR, 0x80000000 | (dev << 11) | (func << 8) | reg);
+	outl (PCI_CONFIG_DATA, value);
+}
+
+/* Looks on PCI bus 0 for an IDE controller capable of bus
+   mastering, enables bus mastering on it, and returns the base
+   of its bus-master I/O ports (the primary channel's; the
+   secondary's follow 8 ports later).  Returns 0 if there is no
+   such controller. */
+static uint16_t
+find_bus_master (void) {
+	int dev, func;
+
+	for (dev = 0; dev < 32; dev++)
+		for (func = 0; func < 8; func++) {
+			uint32_t class, bar4;
+
+			if ((pci_read_config (dev, func, 0x00) & 0xffff) == 0xffff)
+				continue;
+
+			/* Class 01h (mass storage), subclass 01h (IDE), with
+			   bit 7 of the programming interface set (bus master). */
+			class = pci_read_config (dev, func, 0x08);
+			if ((class >> 16) != 0x0101 || !(class & 0x8000))
+				continue;
+
+			/* BAR4 holds the bus-master ports in I/O space. */
+			bar4 = pci_read_config (dev, func, 0x20);
+			if (!(bar4 & 1) || (bar4 & 0xfffc) == 0)
+				continue;
+
+			/* Enable I/O space access and bus mastering. */
+			pci_write_config (dev, func, 0x04,
+					pci_read_config (dev, func, 0x04) | 0x05);
+			return bar4 & 0xfffc;
+		}
+	return 0;
+}
+
 /* Prints STRING, which consists of SIZE bytes in a funky format:
    each pair of bytes is in reverse order.  Does not print
    trailing whitespace and/or nulls. */
@@ -402,17 +976,19 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO to the disk's sector selection registers and CNT
+   to its sector count register.  (We use LBA mode.)  A count of
+   256 is written as 0, as the ATA standard specifies. */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sectors (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (cnt >= 1 && cnt <= DISK_MULTI_MAX);
+	ASSERT (sec_no + cnt <= d->capacity);
+	ASSERT (sec_no + cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), cnt == DISK_MULTI_MAX ? 0 : cnt);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
@@ -421,13 +997,9 @@ select_sector (struct disk *d, disk_sector_t sec_no) {
 }
 
 /* Writes COMMAND to channel C and prepares for receiving a
-   completion interrupt. */
+   completion interrupt.  Also used for the DMA commands. */
 static void
 issue_pio_command (struct channel *c, uint8_t command) {
-	/* Interrupts must be enabled or our semaphore will never be
-	   up'd by the completion handler. */
-	ASSERT (intr_get_level () == INTR_ON);
-
 	c->expecting_interrupt = true;
 	outb (reg_command (c), command);
 }
@@ -445,7 +1017,7 @@ static void
 output_sector (struct channel *c, const void *sector) {
 	outsw (reg_data (c), sector, DISK_SECTOR_SIZE / 2);
 }
-
+
 /* Low-level ATA primitives. */
 
 /* Wait up to 10 seconds for the controller to become idle, that
@@ -460,7 +1032,7 @@ wait_until_idle (const struct disk *d) {
 	for (i = 0; i < 1000; i++) {
 		if ((inb (reg_status (d->channel)) & (STA_BSY | STA_DRQ)) == 0)
 			return;
-		timer_usleep (10);
+		timer_udelay (10);
 	}
 
 	printf ("%s: idle timeout\n", d->name);
@@ -483,7 +1055,13 @@ wait_while_busy (const struct disk *d) {
 				printf ("ok\n");
 			return (inb (reg_alt_status (c)) & STA_DRQ) != 0;
 		}
-		timer_msleep (10);
+
+		/* Requests are also started from the interrupt handler,
+		   which must not sleep. */
+		if (intr_get_level () == INTR_ON)
+			timer_msleep (10);
+		else
+			timer_mdelay (10);
 	}
 
 	printf ("failed\n");
@@ -499,7 +1077,7 @@ select_device (const struct disk *d) {
 		dev |= DEV_DEV;
 	outb (reg_device (c), dev);
 	inb (reg_alt_status (c));
-	timer_nsleep (400);
+	timer_ndelay (400);
 }
 
 /* Select disk D in its channel, as select_device(), but wait for
@@ -518,11 +1096,14 @@ interrupt_handler (struct intr_frame *f) {
 
 	for (c = channels; c < channels + CHANNEL_CNT; c++)
 		if (f->vec_no == c->irq) {
-			if (c->expecting_interrupt) {
+			if (!c->expecting_interrupt)
+				printf ("%s: unexpected interrupt\n", c->name);
+			else if (!list_empty (&c->active))
+				channel_interrupt (c);              /* Queued request. */
+			else {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
 				sema_up (&c->completion_wait);      /* Wake up waiter. */
-			} else
-				printf ("%s: unexpected interrupt\n", c->name);
+			}
 			return;
 		}
 
@@ -17,9 +17,34 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency, in Hz. */
+#define PIT_HZ 1193180
+
+/* 8254 input cycles per timer tick, rounded to nearest. */
+#define TICK_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Longest one-shot, in ticks, that the 16-bit counter can
+   express. */
+#define ONESHOT_MAX_TICKS (0xffff / TICK_COUNT)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* If false (default), the timer interrupts TIMER_FREQ times per
+   second unconditionally.
+   If true, the idle thread reprograms the timer to interrupt only
+   at the next sleeper's wakeup tick.
+   Controlled by kernel command-line option "-tickless". */
+bool timer_tickless;
+
+/* Number of tick boundaries that will have passed when the
+   pending one-shot interrupt arrives, or 0 if the timer is in
+   periodic mode. */
+static int64_t oneshot_ticks;
+
+/* Number of timer interrupts that tickless idle avoided. */
+static int64_t avoided_cnt;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
@@ -28,20 +53,19 @@ static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void real_time_delay (int64_t num, int32_t denom);
+static void pit_set_periodic (void);
+static void pit_set_oneshot (uint16_t count);
+static uint16_t pit_read_count (void);
+static bool pit_output_high (void);
+static bool pit_irq_pending (void);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
    corresponding interrupt. */
 void
 timer_init (void) {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
-
+	pit_set_periodic ();
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -116,23 +140,176 @@ timer_nsleep (int64_t ns) {
 	real_time_sleep (ns, 1000 * 1000 * 1000);
 }
 
+/* Busy-waits for approximately MS milliseconds.  Interrupts need
+   not be turned on.
+
+   Busy waiting wastes CPU cycles, and busy waiting with
+   interrupts off for the interval between timer ticks or longer
+   will cause timer ticks to be lost.  Thus, use timer_msleep()
+   instead if interrupts are enabled. */
+void
+timer_mdelay (int64_t ms) {
+	real_time_delay (ms, 1000);
+}
+
+/* Busy-waits for approximately US microseconds.  Interrupts need
+   not be turned on. */
+void
+timer_udelay (int64_t us) {
+	real_time_delay (us, 1000 * 1000);
+}
+
+/* Busy-waits for approximately NS nanoseconds.  Interrupts need
+   not be turned on. */
+void
+timer_ndelay (int64_t ns) {
+	real_time_delay (ns, 1000 * 1000 * 1000);
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts the CPU.  In tickless mode, replaces the periodic tick by
+   a single interrupt at the tick boundary where the next sleeper
+   is due, or as far ahead as the counter can reach. */
+void
+timer_idle_enter (void) {
+	int64_t delta;
+	uint16_t left;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!timer_tickless || oneshot_ticks != 0)
+		return;
+
+	delta = get_min_awake_tick () - ticks;
+	if (delta > ONESHOT_MAX_TICKS)
+		delta = ONESHOT_MAX_TICKS;
+	if (delta < 2)
+		return;
+
+	/* Keep the one-shot aligned with the periodic tick: it covers
+	   what is left of the current period plus DELTA - 1 full
+	   periods.  Give up if the current period is about to end, or
+	   has already ended and its interrupt is waiting for us to
+	   re-enable interrupts, because timer_interrupt() would then
+	   mistake that interrupt for the one-shot. */
+	left = pit_read_count ();
+	if (left < 64 || pit_irq_pending ())
+		return;
+
+	oneshot_ticks = delta;
+	pit_set_oneshot (left + (delta - 1) * TICK_COUNT);
+}
+
+/* Called by the idle thread, with interrupts off, after an
+   interrupt has woken it up.  If that interrupt was not the
+   timer's, a one-shot is still pending: catches TICKS up to the
+   real time, wakes any sleeper that became due, and arranges for
+   the next interrupt to arrive at the next tick boundary, where
+   timer_interrupt() resumes periodic mode. */
+void
+timer_idle_exit (void) {
+	uint16_t left;
+	int64_t boundaries_left, crossed;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* No one-shot, or it expired and its interrupt is pending. */
+	if (oneshot_ticks == 0 || pit_output_high ())
+		return;
+
+	left = pit_read_count ();
+	boundaries_left = DIV_ROUND_UP (left, TICK_COUNT);
+	crossed = oneshot_ticks - boundaries_left;
+	if (crossed > 0) {
+		ticks += crossed;
+		avoided_cnt += crossed;
+		thread_idle_catchup (crossed);
+		if (get_min_awake_tick () <= ticks)
+			thread_awake (ticks);
+	}
+
+	oneshot_ticks = 1;
+	pit_set_oneshot (left - (boundaries_left - 1) * TICK_COUNT);
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
 	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	if (timer_tickless)
+		printf ("Timer: %"PRId64" interrupts avoided by tickless idle\n",
+				avoided_cnt);
 }
-
+
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
-	ticks++;
-	thread_tick ();
-	
+	int64_t elapsed = 1;
+
+	if (oneshot_ticks != 0) {
+		/* A one-shot from tickless idle expired.  Account for the
+		   ticks it covered and go back to periodic mode. */
+		elapsed = oneshot_ticks;
+		avoided_cnt += oneshot_ticks - 1;
+		oneshot_ticks = 0;
+		pit_set_periodic ();
+	}
+
+	while (elapsed-- > 0) {
+		ticks++;
+		thread_tick ();
+	}
+
 	// tick 확인하고 자고 있는 스레드 깨우기
 	if (get_min_awake_tick() <= ticks) // 깨울 수 있는 스레드가 하나라도 존재하는 경우
 		thread_awake(ticks);
 }
 
+/* Sets up the 8254 Programmable Interval Timer (PIT) to
+   interrupt TIMER_FREQ times per second. */
+static void
+pit_set_periodic (void) {
+	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	outb (0x40, TICK_COUNT & 0xff);
+	outb (0x40, TICK_COUNT >> 8);
+}
+
+/* Sets up the PIT to interrupt once, COUNT input cycles from
+   now. */
+static void
+pit_set_oneshot (uint16_t count) {
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* Returns the current value of the PIT's counter 0. */
+static uint16_t
+pit_read_count (void) {
+	uint8_t lo, hi;
+
+	outb (0x43, 0x00);    /* CW: counter 0, latch count. */
+	lo = inb (0x40);
+	hi = inb (0x40);
+	return lo | (hi << 8);
+}
+
+/* Returns true if counter 0's output is high, which in mode 0
+   means that the one-shot has reached terminal count. */
+static bool
+pit_output_high (void) {
+	outb (0x43, 0xe2);    /* Read-back: latch status of counter 0. */
+	return (inb (0x40) & 0x80) != 0;
+}
+
+/* Returns true if the timer's IRQ is raised at the PIC but not
+   yet delivered. */
+static bool
+pit_irq_pending (void) {
+	outb (0x20, 0x0a);    /* OCW3: read interrupt request register. */
+	return (inb (0x20) & 0x01) != 0;
+}
+
 /* Returns true if LOOPS iterations waits for more than one timer
    tick, otherwise false. */
 static bool
@@ -189,3 +366,12 @@ real_time_sleep (int64_t num, int32_t denom) {
 		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 	}
 }
+
+/* Busy-wait for approximately NUM/DENOM seconds. */
+static void
+real_time_delay (int64_t num, int32_t denom) {
+	/* Scale the numerator and denominator down by 1000 to avoid
+	   the possibility of overflow. */
+	ASSERT (denom % 1000 == 0);
+	busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+}
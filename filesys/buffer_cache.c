@@ -0,0 +1,373 @@
+/* buffer_cache.c: Write-back cache of file system disk sectors. */
+
+#include "filesys/buffer_cache.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/filesys.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of cached sectors. */
+#define CACHE_SIZE 64
+
+/* How often the flush daemon writes dirty sectors back. */
+#define FLUSH_INTERVAL (30 * TIMER_FREQ)
+
+/* Maximum number of pending read-ahead requests. */
+#define READ_AHEAD_MAX 16
+
+/* A cached sector.
+
+   SECTOR, VALID, ACCESSED and PIN_CNT are protected by
+   cache_lock.  DIRTY and DATA are protected by the entry's own
+   LOCK, which its user holds while the entry is pinned.  An
+   unpinned entry has no user, so the eviction code may look at
+   it under cache_lock alone. */
+struct cache_entry {
+	disk_sector_t sector;               /* Cached sector. */
+	bool valid;                         /* Holds a sector? */
+	bool accessed;                      /* Used since the clock hand passed? */
+	bool dirty;                         /* Modified since read or written? */
+	int pin_cnt;                        /* Threads using or waiting for it. */
+	struct lock lock;                   /* Serializes access to DATA. */
+	struct disk_request write_req;      /* Write-back by buffer_cache_flush(). */
+	uint8_t data[DISK_SECTOR_SIZE];     /* Sector contents. */
+};
+
+static struct cache_entry cache[CACHE_SIZE];
+static struct lock cache_lock;          /* Protects the cache directory. */
+static size_t clock_hand;               /* Next eviction candidate. */
+
+/* Read-ahead requests, a ring buffer protected by cache_lock. */
+static disk_sector_t read_ahead_queue[READ_AHEAD_MAX];
+static size_t read_ahead_head, read_ahead_cnt;
+static struct semaphore read_ahead_sema;
+
+/* Statistics. */
+static long long hit_cnt, miss_cnt, ahead_cnt, write_back_cnt;
+static long long direct_cnt;
+
+static struct cache_entry *cache_get (disk_sector_t, bool overwrite);
+static void cache_put (struct cache_entry *);
+static struct cache_entry *cache_find (disk_sector_t);
+static struct cache_entry *cache_evict (void);
+static void flushd (void *aux);
+static void read_aheadd (void *aux);
+
+/* Initializes the buffer cache and starts its flush and
+   read-ahead daemons. */
+void
+buffer_cache_init (void) {
+	size_t i;
+
+	lock_init (&cache_lock);
+	for (i = 0; i < CACHE_SIZE; i++) {
+		cache[i].valid = false;
+		cache[i].pin_cnt = 0;
+		lock_init (&cache[i].lock);
+	}
+	sema_init (&read_ahead_sema, 0);
+
+	thread_create ("flushd", PRI_DEFAULT, flushd, NULL);
+	thread_create ("read-aheadd", PRI_DEFAULT, read_aheadd, NULL);
+}
+
+/* Reads SIZE bytes starting at byte OFS within SECTOR into
+   BUFFER, through the cache. */
+void
+buffer_cache_read (disk_sector_t sector, void *buffer, int ofs, int size) {
+	struct cache_entry *e;
+
+	ASSERT (ofs >= 0 && size >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	e = cache_get (sector, false);
+	memcpy (buffer, e->data + ofs, size);
+	cache_put (e);
+}
+
+/* Writes SIZE bytes from BUFFER to byte OFS within SECTOR, in the
+   cache.  The sector reaches the disk when it is evicted or
+   flushed.  Writing a whole sector does not read it first. */
+void
+buffer_cache_write (disk_sector_t sector, const void *buffer, int ofs,
+		int size) {
+	struct cache_entry *e;
+
+	ASSERT (ofs >= 0 && size >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	e = cache_get (sector, ofs == 0 && size == DISK_SECTOR_SIZE);
+	memcpy (e->data + ofs, buffer, size);
+	e->dirty = true;
+	cache_put (e);
+}
+
+/* Reads CNT contiguous sectors starting at SECTOR into BUFFER,
+   which must have room for CNT * DISK_SECTOR_SIZE bytes.  If none
+   of them is cached, they are read from disk in a single transfer
+   and left out of the cache, since the caller keeps a copy of its
+   own.  Otherwise each sector is read through the cache, which may
+   hold newer data than the disk.  Nobody may write the sectors
+   meanwhile. */
+void
+buffer_cache_read_multi (disk_sector_t sector, size_t cnt, void *buffer_) {
+	uint8_t *buffer = buffer_;
+	bool cached = false;
+	size_t i;
+
+	ASSERT (cnt > 0 && cnt <= DISK_MULTI_MAX);
+
+	lock_acquire (&cache_lock);
+	for (i = 0; i < cnt && !cached; i++)
+		cached = cache_find (sector + i) != NULL;
+	lock_release (&cache_lock);
+
+	if (!cached) {
+		disk_read_multi (filesys_disk, sector, cnt, buffer);
+		direct_cnt += cnt;
+		return;
+	}
+	for (i = 0; i < cnt; i++)
+		buffer_cache_read (sector + i, buffer + i * DISK_SECTOR_SIZE, 0,
+				DISK_SECTOR_SIZE);
+}
+
+/* Asks the read-ahead daemon to bring SECTOR into the cache, if
+   it is not there already.  Does not wait. */
+void
+buffer_cache_read_ahead (disk_sector_t sector) {
+	lock_acquire (&cache_lock);
+	if (cache_find (sector) == NULL && read_ahead_cnt < READ_AHEAD_MAX) {
+		read_ahead_queue[(read_ahead_head + read_ahead_cnt++) % READ_AHEAD_MAX]
+			= sector;
+		sema_up (&read_ahead_sema);
+	}
+	lock_release (&cache_lock);
+}
+
+/* Completion callback for buffer_cache_flush()'s writes. */
+static void
+flush_done (struct disk_request *r) {
+	sema_up (r->aux);
+}
+
+/* Writes every dirty sector back to disk.  The writes are queued
+   all at once and waited for together, so that the disk can sort
+   and merge them while the flushing thread sleeps, instead of
+   taking one round trip per sector.  Entries are locked in index
+   order, so concurrent flushes cannot deadlock. */
+void
+buffer_cache_flush (void) {
+	bool flushing[CACHE_SIZE];
+	struct semaphore done;
+	size_t i, write_cnt = 0;
+
+	sema_init (&done, 0);
+	for (i = 0; i < CACHE_SIZE; i++) {
+		struct cache_entry *e = &cache[i];
+
+		flushing[i] = false;
+		lock_acquire (&cache_lock);
+		if (!e->valid) {
+			lock_release (&cache_lock);
+			continue;
+		}
+		e->pin_cnt++;
+		lock_release (&cache_lock);
+
+		lock_acquire (&e->lock);
+		if (!e->dirty) {
+			cache_put (e);
+			continue;
+		}
+		e->write_req.disk = filesys_disk;
+		e->write_req.sec_no = e->sector;
+		e->write_req.cnt = 1;
+		e->write_req.buffer = e->data;
+		e->write_req.write = true;
+		e->write_req.done = flush_done;
+		e->write_req.aux = &done;
+		disk_submit (&e->write_req);
+		flushing[i] = true;
+		write_cnt++;
+	}
+
+	for (i = 0; i < write_cnt; i++)
+		sema_down (&done);
+	for (i = 0; i < CACHE_SIZE; i++)
+		if (flushing[i]) {
+			cache[i].dirty = false;
+			write_back_cnt++;
+			cache_put (&cache[i]);
+		}
+}
+
+/* Prints buffer cache statistics. */
+void
+buffer_cache_print_stats (void) {
+	printf ("Buffer cache: %lld hits, %lld misses, %lld read-aheads, "
+			"%lld write-backs, %lld sectors read around the cache\n",
+			hit_cnt, miss_cnt, ahead_cnt, write_back_cnt, direct_cnt);
+}
+
+/* Returns the locked and pinned cache entry for SECTOR, reading
+   the sector from disk on a miss unless OVERWRITE is true, in
+   which case the caller is about to replace all of its data.
+   Release the entry with cache_put(). */
+static struct cache_entry *
+cache_get (disk_sector_t sector, bool overwrite) {
+	struct cache_entry *e;
+
+	lock_acquire (&cache_lock);
+	for (;;) {
+		e = cache_find (sector);
+		if (e != NULL) {
+			hit_cnt++;
+			e->accessed = true;
+			e->pin_cnt++;
+			lock_release (&cache_lock);
+
+			/* Waits for a concurrent miss on the same sector to
+			   finish reading the data in. */
+			lock_acquire (&e->lock);
+			return e;
+		}
+
+		e = cache_evict ();
+		if (e != NULL)
+			break;
+
+		/* Every entry is pinned, or cache_evict() dropped
+		   cache_lock to write a victim back.  Let other users
+		   run, then look again, since one of them may have
+		   brought SECTOR in meanwhile. */
+		lock_release (&cache_lock);
+		thread_yield ();
+		lock_acquire (&cache_lock);
+	}
+
+	miss_cnt++;
+	e->sector = sector;
+	e->valid = true;
+	e->accessed = true;
+	e->dirty = false;
+	e->pin_cnt = 1;
+
+	/* Nobody else uses an unpinned entry, so this does not
+	   block.  Taking the lock before publishing the entry makes
+	   later lookups of SECTOR wait for the read below. */
+	lock_acquire (&e->lock);
+	lock_release (&cache_lock);
+
+	if (!overwrite)
+		disk_read (filesys_disk, sector, e->data);
+	return e;
+}
+
+/* Unlocks and unpins E. */
+static void
+cache_put (struct cache_entry *e) {
+	lock_release (&e->lock);
+	lock_acquire (&cache_lock);
+	ASSERT (e->pin_cnt > 0);
+	e->pin_cnt--;
+	lock_release (&cache_lock);
+}
+
+/* Returns the entry caching SECTOR, or a null pointer.  The
+   caller must hold cache_lock. */
+static struct cache_entry *
+cache_find (disk_sector_t sector) {
+	size_t i;
+
+	ASSERT (lock_held_by_current_thread (&cache_lock));
+
+	for (i = 0; i < CACHE_SIZE; i++)
+		if (cache[i].valid && cache[i].sector == sector)
+			return &cache[i];
+	return NULL;
+}
+
+/* Chooses an unpinned entry to reuse with the clock algorithm
+   and returns it, or returns a null pointer if every entry is
+   pinned.  Clean entries are preferred: a dirty entry is only
+   taken on the third sweep.  The caller must hold cache_lock.
+
+   A dirty victim is not returned.  It is pinned and written back
+   with cache_lock released, so that other threads can use the
+   cache meanwhile; lookups of its sector still hit the old data.
+   Then the clock hand is left on it and a null pointer is
+   returned, and the caller must look its sector up again before
+   calling here once more. */
+static struct cache_entry *
+cache_evict (void) {
+	size_t i;
+
+	ASSERT (lock_held_by_current_thread (&cache_lock));
+
+	for (i = 0; i < 3 * CACHE_SIZE; i++) {
+		size_t idx = clock_hand;
+		struct cache_entry *e = &cache[idx];
+		clock_hand = (clock_hand + 1) % CACHE_SIZE;
+
+		if (!e->valid)
+			return e;
+		if (e->pin_cnt > 0)
+			continue;
+		if (e->accessed) {
+			e->accessed = false;
+			continue;
+		}
+		if (e->dirty && i < 2 * CACHE_SIZE)
+			continue;
+
+		if (e->dirty) {
+			/* Nobody holds the lock of an unpinned entry. */
+			e->pin_cnt++;
+			lock_acquire (&e->lock);
+			lock_release (&cache_lock);
+
+			disk_write (filesys_disk, e->sector, e->data);
+			e->dirty = false;
+			lock_release (&e->lock);
+
+			lock_acquire (&cache_lock);
+			e->pin_cnt--;
+			write_back_cnt++;
+			clock_hand = idx;
+			return NULL;
+		}
+		e->valid = false;
+		return e;
+	}
+	return NULL;
+}
+
+/* Flush daemon: periodically writes dirty sectors back, so that
+   a crash loses at most FLUSH_INTERVAL ticks of writes. */
+static void
+flushd (void *aux UNUSED) {
+	for (;;) {
+		timer_sleep (FLUSH_INTERVAL);
+		buffer_cache_flush ();
+	}
+}
+
+/* Read-ahead daemon: reads queued sectors into the cache. */
+static void
+read_aheadd (void *aux UNUSED) {
+	for (;;) {
+		disk_sector_t sector;
+
+		sema_down (&read_ahead_sema);
+		lock_acquire (&cache_lock);
+		sector = read_ahead_queue[read_ahead_head];
+		read_ahead_head = (read_ahead_head + 1) % READ_AHEAD_MAX;
+		read_ahead_cnt--;
+		ahead_cnt++;
+		lock_release (&cache_lock);
+
+		cache_put (cache_get (sector, false));
+	}
+}
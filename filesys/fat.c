@@ -1,4 +1,5 @@
 #include "filesys/fat.h"
+#include <bitmap.h>
 #include "devices/disk.h"
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
@@ -22,8 +23,11 @@ struct fat_fs {
 	unsigned int *fat;
 	unsigned int fat_length;
 	disk_sector_t data_start;
-	cluster_t last_clst;
-	struct lock write_lock;
+	cluster_t last_clst;        /* Where the next free-cluster search starts. */
+	struct lock write_lock;     /* Serializes changes to the FAT. */
+	struct bitmap *used_map;    /* Clusters in use, built at mount. */
+	size_t free_cnt;            /* Number of free clusters. */
+	struct bitmap *dirty_map;   /* FAT sectors changed since written. */
 };
 
 static struct fat_fs *fat_fs;
@@ -31,6 +35,10 @@ static struct fat_fs *fat_fs;
 void fat_boot_create (void);
 void fat_fs_init (void);
 
+static void fat_build_maps (void);
+static void fat_set (cluster_t clst, cluster_t val);
+static cluster_t fat_alloc_cluster (cluster_t hint);
+
 void
 fat_init (void) {
 	fat_fs = calloc (1, sizeof (struct fat_fs));
@@ -53,31 +61,29 @@ fat_init (void) {
 
 void
 fat_open (void) {
-	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
+	// Right after formatting, fat_create() has already built the
+	// table and its bitmaps in memory.
+	if (fat_fs->fat != NULL)
+		return;
+
+	// The table is kept in whole sectors, so that any one of them
+	// can be written back by itself.
+	fat_fs->fat = calloc (fat_fs->bs.fat_sectors, DISK_SECTOR_SIZE);
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT load failed");
 
-	// Load FAT directly from the disk
+	// Load FAT directly from the disk, as many sectors per command
+	// as the disk driver allows.
 	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_read = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_read;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i,
-			           buffer + bytes_read);
-			bytes_read += DISK_SECTOR_SIZE;
-		} else {
-			uint8_t *bounce = malloc (DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT load failed");
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			memcpy (buffer + bytes_read, bounce, bytes_left);
-			bytes_read += bytes_left;
-			free (bounce);
-		}
+	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; ) {
+		unsigned cnt = fat_fs->bs.fat_sectors - i;
+		if (cnt > DISK_MULTI_MAX)
+			cnt = DISK_MULTI_MAX;
+		disk_read_multi (filesys_disk, fat_fs->bs.fat_start + i, cnt,
+		                 buffer + i * DISK_SECTOR_SIZE);
+		i += cnt;
 	}
+	fat_build_maps ();
 }
 
 void
@@ -90,27 +96,25 @@ fat_close (void) {
 	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
 	free (bounce);
 
-	// Write FAT directly to the disk
+	// Write back only the FAT sectors that changed, each run of
+	// consecutive dirty sectors as one command.
 	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
-		} else {
-			bounce = calloc (1, DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
-			free (bounce);
-		}
+	lock_acquire (&fat_fs->write_lock);
+	for (size_t i = 0; i < fat_fs->bs.fat_sectors; ) {
+		size_t cnt = 0;
+
+		i = bitmap_scan (fat_fs->dirty_map, i, 1, true);
+		if (i == BITMAP_ERROR)
+			break;
+		while (i + cnt < fat_fs->bs.fat_sectors && cnt < DISK_MULTI_MAX
+		       && bitmap_test (fat_fs->dirty_map, i + cnt))
+			cnt++;
+		disk_write_multi (filesys_disk, fat_fs->bs.fat_start + i, cnt,
+		                  buffer + i * DISK_SECTOR_SIZE);
+		bitmap_set_multiple (fat_fs->dirty_map, i, cnt, false);
+		i += cnt;
 	}
+	lock_release (&fat_fs->write_lock);
 }
 
 void
@@ -120,9 +124,13 @@ fat_create (void) {
 	fat_fs_init ();
 
 	// Create FAT table
-	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
+	fat_fs->fat = calloc (fat_fs->bs.fat_sectors, DISK_SECTOR_SIZE);
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT creation failed");
+	fat_build_maps ();
+
+	// The whole table is new.
+	bitmap_set_all (fat_fs->dirty_map, true);
 
 	// Set up ROOT_DIR_CLST
 	fat_put (ROOT_DIR_CLUSTER, EOChain);
@@ -152,7 +160,32 @@ fat_boot_create (void) {
 
 void
 fat_fs_init (void) {
-	/* TODO: Your code goes here. */
+	// Data clusters follow the FAT.  Cluster 0 is not a real
+	// cluster: a FAT entry of 0 means "free", so the first data
+	// sector holds cluster 1, the root directory.
+	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors;
+	fat_fs->fat_length = (fat_fs->bs.total_sectors - fat_fs->data_start)
+	                     / SECTORS_PER_CLUSTER + 1;
+	fat_fs->last_clst = ROOT_DIR_CLUSTER;
+	lock_init (&fat_fs->write_lock);
+}
+
+/* Builds the free-cluster and dirty-sector bitmaps for the FAT
+ * just loaded or created, with one pass over the table. */
+static void
+fat_build_maps (void) {
+	fat_fs->used_map = bitmap_create (fat_fs->fat_length);
+	fat_fs->dirty_map = bitmap_create (fat_fs->bs.fat_sectors);
+	if (fat_fs->used_map == NULL || fat_fs->dirty_map == NULL)
+		PANIC ("FAT bitmap creation failed");
+
+	bitmap_mark (fat_fs->used_map, 0);
+	fat_fs->free_cnt = fat_fs->fat_length - 1;
+	for (cluster_t clst = 1; clst < fat_fs->fat_length; clst++)
+		if (fat_fs->fat[clst] != 0) {
+			bitmap_mark (fat_fs->used_map, clst);
+			fat_fs->free_cnt--;
+		}
 }
 
 /*----------------------------------------------------------------------------*/
@@ -161,33 +194,112 @@ fat_fs_init (void) {
 
 /* Add a cluster to the chain.
  * If CLST is 0, start a new chain.
- * Returns 0 if fails to allocate a new cluster. */
+ * Returns 0 if fails to allocate a new cluster.
+ * CLST must be the last cluster of its chain, so that growing a
+ * file does not walk the chain.  The new cluster is the one right
+ * after CLST on disk when that is free, so that files grown a
+ * cluster at a time stay sequential. */
 cluster_t
 fat_create_chain (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	cluster_t new;
+
+	lock_acquire (&fat_fs->write_lock);
+	ASSERT (clst == 0
+	        || (clst < fat_fs->fat_length && fat_fs->fat[clst] == EOChain));
+	new = fat_alloc_cluster (clst != 0 ? clst + 1 : fat_fs->last_clst);
+	if (new != 0) {
+		fat_set (new, EOChain);
+		if (clst != 0)
+			fat_set (clst, new);
+	}
+	lock_release (&fat_fs->write_lock);
+	return new;
 }
 
 /* Remove the chain of clusters starting from CLST.
  * If PCLST is 0, assume CLST as the start of the chain. */
 void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	if (pclst != 0)
+		fat_set (pclst, EOChain);
+	while (clst != 0 && clst != EOChain) {
+		cluster_t next;
+
+		ASSERT (clst < fat_fs->fat_length);
+		next = fat_fs->fat[clst];
+		fat_set (clst, 0);
+		clst = next;
+	}
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Update a value in the FAT table. */
 void
 fat_put (cluster_t clst, cluster_t val) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	fat_set (clst, val);
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Fetch a value in the FAT table. */
 cluster_t
 fat_get (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst >= 1 && clst < fat_fs->fat_length);
+
+	return fat_fs->fat[clst];
 }
 
 /* Covert a cluster # to a sector number. */
 disk_sector_t
 cluster_to_sector (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst >= 1 && clst < fat_fs->fat_length);
+
+	return fat_fs->data_start + (clst - 1) * SECTORS_PER_CLUSTER;
+}
+
+/* Sets the FAT entry for CLST to VAL, keeping the free-cluster
+ * bitmap in step and marking the entry's sector dirty.  The caller
+ * must hold write_lock. */
+static void
+fat_set (cluster_t clst, cluster_t val) {
+	ASSERT (clst >= 1 && clst < fat_fs->fat_length);
+	ASSERT (lock_held_by_current_thread (&fat_fs->write_lock));
+
+	if (fat_fs->fat[clst] == 0 && val != 0) {
+		bitmap_mark (fat_fs->used_map, clst);
+		fat_fs->free_cnt--;
+	} else if (fat_fs->fat[clst] != 0 && val == 0) {
+		bitmap_reset (fat_fs->used_map, clst);
+		fat_fs->free_cnt++;
+	}
+	fat_fs->fat[clst] = val;
+	bitmap_mark (fat_fs->dirty_map,
+	             clst * sizeof (cluster_t) / DISK_SECTOR_SIZE);
+}
+
+/* Returns a free cluster: HINT itself if it is free, or else the
+ * next free one after where the last search ended, wrapping
+ * around.  Because each search resumes where the previous one
+ * stopped, a series of allocations passes over each cluster about
+ * once per lap of the disk instead of rescanning from the start
+ * every time.  The cluster is not yet marked used: fat_set() does
+ * that.  Returns 0 if the disk is full.  The caller must hold
+ * write_lock. */
+static cluster_t
+fat_alloc_cluster (cluster_t hint) {
+	size_t clst;
+
+	if (fat_fs->free_cnt == 0)
+		return 0;
+	if (hint >= 1 && hint < fat_fs->fat_length
+	    && !bitmap_test (fat_fs->used_map, hint))
+		return hint;
+
+	clst = bitmap_scan (fat_fs->used_map, fat_fs->last_clst, 1, false);
+	if (clst == BITMAP_ERROR)
+		clst = bitmap_scan (fat_fs->used_map, 1, 1, false);
+	ASSERT (clst != BITMAP_ERROR);
+	fat_fs->last_clst = clst + 1 < fat_fs->fat_length ? clst + 1 : 1;
+	return clst;
 }
@@ -2,11 +2,15 @@
 #include <debug.h>
 #include <stdio.h>
 #include <string.h>
+#include "filesys/buffer_cache.h"
 #include "filesys/file.h"
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
 #include "devices/disk.h"
+#if defined (VM) && defined (EFILESYS)
+#include "filesys/page_cache.h"
+#endif
 
 /* The disk that contains the file system. */
 struct disk *filesys_disk;
@@ -21,7 +25,9 @@ filesys_init (bool format) {
 	if (filesys_disk == NULL)
 		PANIC ("hd0:1 (hdb) not present, file system initialization failed");
 
+	buffer_cache_init ();
 	inode_init ();
+	dir_init ();
 
 #ifdef EFILESYS
 	fat_init ();
@@ -46,11 +52,15 @@ filesys_init (bool format) {
 void
 filesys_done (void) {
 	/* Original FS */
+#if defined (VM) && defined (EFILESYS)
+	page_cache_flush ();
+#endif
 #ifdef EFILESYS
 	fat_close ();
 #else
 	free_map_close ();
 #endif
+	buffer_cache_flush ();
 }
 
 /* Creates a file named NAME with the given INITIAL_SIZE.
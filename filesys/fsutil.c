@@ -1,5 +1,6 @@
 #include "filesys/fsutil.h"
 #include <debug.h>
+#include <round.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +12,10 @@
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
 
+/* Number of scratch disk sectors moved per disk command by
+   fsutil_put() and fsutil_get(). */
+#define COPY_SECTORS (PGSIZE / DISK_SECTOR_SIZE)
+
 /* List files in the root directory. */
 void
 fsutil_ls (char **argv UNUSED) {
@@ -87,7 +92,7 @@ fsutil_put (char **argv) {
 	printf ("Putting '%s' into the file system...\n", file_name);
 
 	/* Allocate buffer. */
-	buffer = malloc (DISK_SECTOR_SIZE);
+	buffer = malloc (COPY_SECTORS * DISK_SECTOR_SIZE);
 	if (buffer == NULL)
 		PANIC ("couldn't allocate buffer");
 
@@ -113,8 +118,11 @@ fsutil_put (char **argv) {
 
 	/* Do copy. */
 	while (size > 0) {
-		int chunk_size = size > DISK_SECTOR_SIZE ? DISK_SECTOR_SIZE : size;
-		disk_read (src, sector++, buffer);
+		int chunk_size = size > COPY_SECTORS * DISK_SECTOR_SIZE
+			? COPY_SECTORS * DISK_SECTOR_SIZE : size;
+		size_t sectors = DIV_ROUND_UP (chunk_size, DISK_SECTOR_SIZE);
+		disk_read_multi (src, sector, sectors, buffer);
+		sector += sectors;
 		if (file_write (dst, buffer, chunk_size) != chunk_size)
 			PANIC ("%s: write failed with %"PROTd" bytes unwritten",
 					file_name, size);
@@ -150,7 +158,7 @@ fsutil_get (char **argv) {
 	printf ("Getting '%s' from the file system...\n", file_name);
 
 	/* Allocate buffer. */
-	buffer = malloc (DISK_SECTOR_SIZE);
+	buffer = malloc (COPY_SECTORS * DISK_SECTOR_SIZE);
 	if (buffer == NULL)
 		PANIC ("couldn't allocate buffer");
 
@@ -173,13 +181,17 @@ fsutil_get (char **argv) {
 
 	/* Do copy. */
 	while (size > 0) {
-		int chunk_size = size > DISK_SECTOR_SIZE ? DISK_SECTOR_SIZE : size;
-		if (sector >= disk_size (dst))
+		int chunk_size = size > COPY_SECTORS * DISK_SECTOR_SIZE
+			? COPY_SECTORS * DISK_SECTOR_SIZE : size;
+		size_t sectors = DIV_ROUND_UP (chunk_size, DISK_SECTOR_SIZE);
+		if (sector + sectors > disk_size (dst))
 			PANIC ("%s: out of space on scratch disk", file_name);
 		if (file_read (src, buffer, chunk_size) != chunk_size)
 			PANIC ("%s: read failed with %"PROTd" bytes unread", file_name, size);
-		memset (buffer + chunk_size, 0, DISK_SECTOR_SIZE - chunk_size);
-		disk_write (dst, sector++, buffer);
+		memset (buffer + chunk_size, 0,
+				sectors * DISK_SECTOR_SIZE - chunk_size);
+		disk_write_multi (dst, sector, sectors, buffer);
+		sector += sectors;
 		size -= chunk_size;
 	}
 
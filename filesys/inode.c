@@ -1,11 +1,16 @@
 #include "filesys/inode.h"
-#include <list.h>
+#include <hash.h>
 #include <debug.h>
 #include <round.h>
 #include <string.h>
+#include "filesys/buffer_cache.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#if defined (VM) && defined (EFILESYS)
+#include "filesys/page_cache.h"
+#endif
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -26,13 +31,20 @@ bytes_to_sectors (off_t size) {
 	return DIV_ROUND_UP (size, DISK_SECTOR_SIZE);
 }
 
+/* An inode's entry in open_inodes.  Lookups only need to build
+ * one of these, not a whole `struct inode'. */
+struct inode_key {
+	struct hash_elem elem;              /* Element in open_inodes. */
+	disk_sector_t sector;               /* Sector number of disk location. */
+};
+
 /* In-memory inode. */
 struct inode {
-	struct list_elem elem;              /* Element in inode list. */
-	disk_sector_t sector;               /* Sector number of disk location. */
+	struct inode_key key;               /* Entry in open_inodes. */
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	struct rwlock rwlock;               /* Readers share, writers exclusive. */
 	struct inode_disk data;             /* Inode content. */
 };
 
@@ -40,7 +52,7 @@ struct inode {
  * INODE.
  * Returns -1 if INODE does not contain data for a byte at offset
  * POS. */
-static disk_sector_t
+disk_sector_t
 byte_to_sector (const struct inode *inode, off_t pos) {
 	ASSERT (inode != NULL);
 	if (pos < inode->data.length)
@@ -49,14 +61,42 @@ byte_to_sector (const struct inode *inode, off_t pos) {
 		return -1;
 }
 
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+/* Open inodes keyed by sector, so that opening a single inode
+ * twice returns the same `struct inode'. */
+static struct hash open_inodes;
+
+/* Protects open_inodes and each inode's open_cnt.  Everything
+ * else in an open inode is protected by the inode's own rwlock,
+ * so I/O on different inodes proceeds concurrently.  The lock is
+ * never held across disk I/O. */
+static struct lock open_inodes_lock;
+
+static uint64_t inode_hash (const struct hash_elem *, void *aux);
+static bool inode_less (const struct hash_elem *, const struct hash_elem *,
+		void *aux);
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	if (!hash_init (&open_inodes, inode_hash, inode_less, NULL))
+		PANIC ("open inode table creation failed");
+	lock_init (&open_inodes_lock);
+}
+
+/* Returns a hash value for the sector of the inode key
+ * containing E. */
+static uint64_t
+inode_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_int (hash_entry (e, struct inode_key, elem)->sector);
+}
+
+/* Returns true if the inode key containing A is at a lower sector
+ * than the one containing B. */
+static bool
+inode_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct inode_key, elem)->sector
+		< hash_entry (b, struct inode_key, elem)->sector;
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -81,13 +121,14 @@ inode_create (disk_sector_t sector, off_t length) {
 		disk_inode->length = length;
 		disk_inode->magic = INODE_MAGIC;
 		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
+			buffer_cache_write (sector, disk_inode, 0, DISK_SECTOR_SIZE);
 			if (sectors > 0) {
 				static char zeros[DISK_SECTOR_SIZE];
 				size_t i;
 
 				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
+					buffer_cache_write (disk_inode->start + i, zeros, 0,
+							DISK_SECTOR_SIZE); 
 			}
 			success = true; 
 		} 
@@ -101,46 +142,67 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
+	struct inode_key key;
+	struct hash_elem *e;
 	struct inode *inode;
 
+	lock_acquire (&open_inodes_lock);
+
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
+	key.sector = sector;
+	e = hash_find (&open_inodes, &key.elem);
+	if (e != NULL) {
+		inode = hash_entry (e, struct inode, key.elem);
+		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+
+		/* Wait until the thread that opened it first has read it
+		 * in. */
+		rwlock_read_acquire (&inode->rwlock);
+		rwlock_read_release (&inode->rwlock);
+		return inode; 
 	}
 
 	/* Allocate memory. */
 	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	if (inode == NULL) {
+		lock_release (&open_inodes_lock);
 		return NULL;
+	}
 
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
-	inode->sector = sector;
+	/* Initialize.  The inode goes into the table before it is read
+	 * in, so that the disk read does not hold up the whole table.
+	 * Its rwlock is held for writing until then, and anyone who
+	 * finds the inode meanwhile waits for it. */
+	inode->key.sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	rwlock_init (&inode->rwlock);
+	rwlock_write_acquire (&inode->rwlock);
+	hash_insert (&open_inodes, &inode->key.elem);
+	lock_release (&open_inodes_lock);
+
+	buffer_cache_read (sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	rwlock_write_release (&inode->rwlock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
 /* Returns INODE's inode number. */
 disk_sector_t
 inode_get_inumber (const struct inode *inode) {
-	return inode->sector;
+	return inode->key.sector;
 }
 
 /* Closes INODE and writes it to disk.
@@ -153,19 +215,27 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
+	lock_acquire (&open_inodes_lock);
 	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
+		/* Remove from inode table and release lock. */
+		hash_delete (&open_inodes, &inode->key.elem);
+		lock_release (&open_inodes_lock);
 
-		/* Deallocate blocks if removed. */
+		/* Deallocate blocks if removed.  Its cached pages go
+		 * first, so that they are not written back to sectors
+		 * another file may get. */
 		if (inode->removed) {
-			free_map_release (inode->sector, 1);
+#if defined (VM) && defined (EFILESYS)
+			page_cache_drop (inode);
+#endif
+			free_map_release (inode->key.sector, 1);
 			free_map_release (inode->data.start,
 					bytes_to_sectors (inode->data.length)); 
 		}
 
 		free (inode); 
-	}
+	} else
+		lock_release (&open_inodes_lock);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -178,16 +248,27 @@ inode_remove (struct inode *inode) {
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
  * Returns the number of bytes actually read, which may be less
- * than SIZE if an error occurs or end of file is reached. */
+ * than SIZE if an error occurs or end of file is reached.
+ * BUFFER is written with INODE's rwlock held, so touching it must
+ * not fault: with VM, system calls pin user buffers first.
+ * Once the page cache is up, the data comes from there. */
 off_t
 inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
-
+	disk_sector_t sector_idx = -1;
+
+	rwlock_read_acquire (&inode->rwlock);
+#if defined (VM) && defined (EFILESYS)
+	if (page_cache_enabled) {
+		bytes_read = page_cache_read (inode, buffer, size, offset);
+		rwlock_read_release (&inode->rwlock);
+		return bytes_read;
+	}
+#endif
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
-		disk_sector_t sector_idx = byte_to_sector (inode, offset);
+		sector_idx = byte_to_sector (inode, offset);
 		int sector_ofs = offset % DISK_SECTOR_SIZE;
 
 		/* Bytes left in inode, bytes left in sector, lesser of the two. */
@@ -200,27 +281,23 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
-		} else {
-			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
-		}
+		buffer_cache_read (sector_idx, buffer + bytes_read, sector_ofs,
+				chunk_size);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free (bounce);
+
+	/* Start fetching the sector after the last one read, on the
+	 * guess that the file is being read sequentially. */
+	if (bytes_read > 0 && offset < inode_length (inode)) {
+		disk_sector_t next_sector = byte_to_sector (inode, offset);
+		if (next_sector != sector_idx)
+			buffer_cache_read_ahead (next_sector);
+	}
+	rwlock_read_release (&inode->rwlock);
 
 	return bytes_read;
 }
@@ -228,6 +305,8 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
  * Returns the number of bytes actually written, which may be
  * less than SIZE if end of file is reached or an error occurs.
+ * As in inode_read_at(), BUFFER must not fault, and the data goes
+ * to the page cache once it is up.
  * (Normally a write at end of file would extend the inode, but
  * growth is not yet implemented.) */
 off_t
@@ -235,10 +314,19 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
 	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
 
-	if (inode->deny_write_cnt)
+	rwlock_write_acquire (&inode->rwlock);
+	if (inode->deny_write_cnt) {
+		rwlock_write_release (&inode->rwlock);
 		return 0;
+	}
+#if defined (VM) && defined (EFILESYS)
+	if (page_cache_enabled) {
+		bytes_written = page_cache_write (inode, buffer, size, offset);
+		rwlock_write_release (&inode->rwlock);
+		return bytes_written;
+	}
+#endif
 
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
@@ -255,34 +343,17 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
-		} else {
-			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-
-			/* If the sector contains data before or after the chunk
-			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
-				disk_read (filesys_disk, sector_idx, bounce);
-			else
-				memset (bounce, 0, DISK_SECTOR_SIZE);
-			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			disk_write (filesys_disk, sector_idx, bounce); 
-		}
+		/* The cache reads in the rest of a partially written
+		 * sector. */
+		buffer_cache_write (sector_idx, buffer + bytes_written, sector_ofs,
+				chunk_size);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
-	free (bounce);
+	rwlock_write_release (&inode->rwlock);
 
 	return bytes_written;
 }
@@ -292,8 +363,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	void
 inode_deny_write (struct inode *inode) 
 {
+	rwlock_write_acquire (&inode->rwlock);
 	inode->deny_write_cnt++;
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+	rwlock_write_release (&inode->rwlock);
 }
 
 /* Re-enables writes to INODE.
@@ -301,9 +374,11 @@ inode_deny_write (struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void
 inode_allow_write (struct inode *inode) {
+	rwlock_write_acquire (&inode->rwlock);
 	ASSERT (inode->deny_write_cnt > 0);
 	ASSERT (inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	rwlock_write_release (&inode->rwlock);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
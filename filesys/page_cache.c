@@ -1,6 +1,31 @@
-/* page_cache.c: Implementation of Page Cache (Buffer Cache). */
+/* page_cache.c: Implementation of Page Cache (Buffer Cache).
+
+   With VM and EFILESYS, file data is cached a page at a time in
+   frames of the VM frame table.  The first page of such a frame is
+   a VM_PAGE_CACHE page, which belongs to no process, and mmap()
+   maps the same frame, so read(), write() and mapped pages share
+   one copy of the data (see vm_cache_get()).  The frames are
+   evicted like any other frame: swap_in fills a page from disk and
+   swap_out writes it back into the sector buffer cache.
+
+   page_cache_kworkerd does the work nobody should wait for: it
+   reads in the page after one that is being read sequentially, and
+   every WRITEBACK_INTERVAL ticks it writes all dirty pages back. */
 
 #include "vm/vm.h"
+#include "filesys/page_cache.h"
+#if defined (VM) && defined (EFILESYS)
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/buffer_cache.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "devices/timer.h"
+#endif
+
 static bool page_cache_readahead (struct page *page, void *kva);
 static bool page_cache_writeback (struct page *page);
 static void page_cache_destroy (struct page *page);
@@ -15,36 +40,330 @@ static const struct page_operations page_cache_op = {
 
 tid_t page_cache_workerd;
 
+#if defined (VM) && defined (EFILESYS)
+/* How often dirty pages are written back. */
+#define WRITEBACK_INTERVAL (30 * TIMER_FREQ)
+
+/* Maximum number of pending read-ahead requests. */
+#define READ_AHEAD_MAX 16
+
+/* A read-ahead request: page OFS of INODE, which the request keeps
+   open. */
+struct read_ahead {
+	struct inode *inode;
+	off_t ofs;
+};
+
+/* Work for kworkerd, protected by work_lock.  work_sema is upped
+   once for each queued read-ahead and once for a pending
+   writeback. */
+static struct read_ahead read_ahead_queue[READ_AHEAD_MAX];
+static size_t read_ahead_head, read_ahead_cnt;
+static bool writeback_pending;
+static struct lock work_lock;
+static struct semaphore work_sema;
+
+/* Statistics. */
+static long long fill_cnt, ahead_cnt, write_back_cnt;
+
+bool page_cache_enabled;
+
+static void page_cache_read_ahead (struct inode *, off_t ofs);
+static void page_cache_kworkerd (void *aux);
+static void page_cache_timerd (void *aux);
+#endif
+
 /* The initializer of file vm */
 void
 pagecache_init (void) {
-	/* TODO: Create a worker daemon for page cache with page_cache_kworkerd */
+	page_cache_workerd = TID_ERROR;
+#if defined (VM) && defined (EFILESYS)
+	lock_init (&work_lock);
+	sema_init (&work_sema, 0);
+	page_cache_workerd = thread_create ("kworkerd", PRI_DEFAULT,
+			page_cache_kworkerd, NULL);
+	thread_create ("kworkerd-timer", PRI_DEFAULT, page_cache_timerd, NULL);
+#endif
 }
 
 /* Initialize the page cache */
 bool
-page_cache_initializer (struct page *page, enum vm_type type, void *kva) {
+page_cache_initializer (struct page *page, enum vm_type type UNUSED,
+		void *kva UNUSED) {
 	/* Set up the handler */
 	page->operations = &page_cache_op;
+#if defined (VM) && defined (EFILESYS)
+	memset (&page->page_cache, 0, sizeof page->page_cache);
+	return true;
+#else
+	return false;
+#endif
+}
+
+#if defined (VM) && defined (EFILESYS)
+/* Returns a new page cache page for page OFS of INODE, which must
+   be within the file, or a null pointer if memory is short.  The
+   page has no frame yet. */
+struct page *
+page_cache_alloc (struct inode *inode, off_t ofs) {
+	off_t length = inode_length (inode);
+	struct page *page;
+	struct page_cache *pc;
+	size_t i;
 
+	ASSERT (ofs % PGSIZE == 0 && ofs < length);
+
+	page = malloc (sizeof *page);
+	if (page == NULL)
+		return NULL;
+	page->va = NULL;
+	page->frame = NULL;
+	page->writable = true;
+	page->owner = NULL;
+	page_cache_initializer (page, VM_PAGE_CACHE, NULL);
+
+	pc = &page->page_cache;
+	pc->read_bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+	for (i = 0; i < PAGE_CACHE_SECTORS; i++)
+		pc->sectors[i] = byte_to_sector (inode, ofs + i * DISK_SECTOR_SIZE);
+	return page;
 }
 
+/* Reads SIZE bytes from INODE into BUFFER, starting at OFFSET,
+   through the page cache, and returns the number of bytes read.
+   Reading on from the start of a page asks kworkerd for the next
+   one.  The caller holds INODE's rwlock. */
+off_t
+page_cache_read (struct inode *inode, void *buffer_, off_t size,
+		off_t offset) {
+	uint8_t *buffer = buffer_;
+	off_t length = inode_length (inode);
+	off_t start = offset;
+	off_t bytes_read = 0;
+
+	while (size > 0 && offset < length) {
+		/* Page to read, starting byte offset within page. */
+		off_t page_ofs = offset % PGSIZE;
+		off_t chunk_size = PGSIZE - page_ofs;
+		struct frame *frame;
+
+		if (chunk_size > size)
+			chunk_size = size;
+		if (chunk_size > length - offset)
+			chunk_size = length - offset;
+
+		frame = vm_cache_get (inode, offset - page_ofs, true);
+		if (frame == NULL)
+			break;
+		memcpy (buffer + bytes_read, (uint8_t *) frame->kva + page_ofs,
+				chunk_size);
+		frame->page->page_cache.accessed = true;
+		vm_cache_put (frame);
+
+		/* Advance. */
+		size -= chunk_size;
+		offset += chunk_size;
+		bytes_read += chunk_size;
+	}
+
+	/* A read that began at a page boundary or went on into a new
+	   page is probably sequential. */
+	if (bytes_read > 0
+			&& (start % PGSIZE == 0 || start / PGSIZE != (offset - 1) / PGSIZE))
+		page_cache_read_ahead (inode, ROUND_UP (offset, PGSIZE));
+	return bytes_read;
+}
+
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET,
+   through the page cache, and returns the number of bytes
+   written.  The data reaches the disk when the pages are written
+   back.  The caller holds INODE's rwlock for writing. */
+off_t
+page_cache_write (struct inode *inode, const void *buffer_, off_t size,
+		off_t offset) {
+	const uint8_t *buffer = buffer_;
+	off_t length = inode_length (inode);
+	off_t bytes_written = 0;
+
+	while (size > 0 && offset < length) {
+		/* Page to write, starting byte offset within page. */
+		off_t page_ofs = offset % PGSIZE;
+		off_t chunk_size = PGSIZE - page_ofs;
+		struct frame *frame;
+
+		if (chunk_size > size)
+			chunk_size = size;
+		if (chunk_size > length - offset)
+			chunk_size = length - offset;
+
+		frame = vm_cache_get (inode, offset - page_ofs, true);
+		if (frame == NULL)
+			break;
+		memcpy ((uint8_t *) frame->kva + page_ofs, buffer + bytes_written,
+				chunk_size);
+		frame->page->page_cache.dirty = true;
+		frame->page->page_cache.accessed = true;
+		vm_cache_put (frame);
+
+		/* Advance. */
+		size -= chunk_size;
+		offset += chunk_size;
+		bytes_written += chunk_size;
+	}
+	return bytes_written;
+}
+
+/* Writes every dirty page back to the buffer cache. */
+void
+page_cache_flush (void) {
+	if (page_cache_enabled)
+		vm_cache_writeback ();
+}
+
+/* Discards INODE's pages, see vm_cache_drop(). */
+void
+page_cache_drop (struct inode *inode) {
+	if (page_cache_enabled)
+		vm_cache_drop (inode);
+}
+
+/* Prints page cache statistics. */
+void
+page_cache_print_stats (void) {
+	printf ("Page cache: %lld pages read, %lld read ahead, "
+			"%lld written back\n",
+			fill_cnt, ahead_cnt, write_back_cnt);
+}
+
+/* Asks kworkerd to read in page OFS of INODE, if it is in the file
+   and not cached yet.  Does not wait. */
+static void
+page_cache_read_ahead (struct inode *inode, off_t ofs) {
+	if (ofs >= inode_length (inode) || vm_cache_resident (inode, ofs))
+		return;
+
+	lock_acquire (&work_lock);
+	if (read_ahead_cnt < READ_AHEAD_MAX) {
+		struct read_ahead *ra = &read_ahead_queue[(read_ahead_head
+				+ read_ahead_cnt++) % READ_AHEAD_MAX];
+
+		ra->inode = inode_reopen (inode);
+		ra->ofs = ofs;
+		sema_up (&work_sema);
+	}
+	lock_release (&work_lock);
+}
+#endif
+
 /* Utilze the Swap in mechanism to implement readhead */
+/* 연속한 sector들은 한 번에 읽어서, sector마다 따로 PIO로 옮기지
+   않는다. */
 static bool
-page_cache_readahead (struct page *page, void *kva) {
+page_cache_readahead (struct page *page UNUSED, void *kva UNUSED) {
+#if defined (VM) && defined (EFILESYS)
+	struct page_cache *pc = &page->page_cache;
+	size_t sector_cnt = DIV_ROUND_UP (pc->read_bytes, DISK_SECTOR_SIZE);
+	size_t i, run;
+
+	for (i = 0; i < sector_cnt; i += run) {
+		for (run = 1; i + run < sector_cnt
+				&& pc->sectors[i + run] == pc->sectors[i] + run; run++)
+			continue;
+		buffer_cache_read_multi (pc->sectors[i], run,
+				(uint8_t *) kva + i * DISK_SECTOR_SIZE);
+	}
+	memset ((uint8_t *) kva + pc->read_bytes, 0, PGSIZE - pc->read_bytes);
+	fill_cnt++;
+	return true;
+#else
+	return false;
+#endif
 }
 
 /* Utilze the Swap out mechanism to implement writeback */
+/* dirty를 먼저 지우므로, 쓰는 도중에 다시 dirty가 된 page는 다음
+   writeback에서 또 써진다. */
 static bool
-page_cache_writeback (struct page *page) {
+page_cache_writeback (struct page *page UNUSED) {
+#if defined (VM) && defined (EFILESYS)
+	struct page_cache *pc = &page->page_cache;
+	const uint8_t *kva = page->frame->kva;
+	size_t ofs;
+
+	if (!pc->dirty)
+		return true;
+	pc->dirty = false;
+	for (ofs = 0; ofs < pc->read_bytes; ofs += DISK_SECTOR_SIZE) {
+		size_t left = pc->read_bytes - ofs;
+
+		buffer_cache_write (pc->sectors[ofs / DISK_SECTOR_SIZE], kva + ofs, 0,
+				left < DISK_SECTOR_SIZE ? left : DISK_SECTOR_SIZE);
+	}
+	write_back_cnt++;
+	return true;
+#else
+	return false;
+#endif
 }
 
 /* Destory the page_cache. */
 static void
-page_cache_destroy (struct page *page) {
+page_cache_destroy (struct page *page UNUSED) {
+#if defined (VM) && defined (EFILESYS)
+	if (page->frame != NULL)
+		page_cache_writeback (page);
+#endif
 }
 
+#if defined (VM) && defined (EFILESYS)
 /* Worker thread for page cache */
+/* read-ahead는 evict하지 않는다.  user pool이 차 있으면 읽지 않고
+   넘어간다. */
+static void
+page_cache_kworkerd (void *aux UNUSED) {
+	for (;;) {
+		struct read_ahead ra;
+		bool writeback = false;
+
+		sema_down (&work_sema);
+		lock_acquire (&work_lock);
+		if (writeback_pending) {
+			writeback_pending = false;
+			writeback = true;
+		} else {
+			ra = read_ahead_queue[read_ahead_head];
+			read_ahead_head = (read_ahead_head + 1) % READ_AHEAD_MAX;
+			read_ahead_cnt--;
+		}
+		lock_release (&work_lock);
+
+		if (writeback) {
+			page_cache_flush ();
+			buffer_cache_flush ();
+		} else {
+			struct frame *frame = vm_cache_get (ra.inode, ra.ofs, false);
+
+			if (frame != NULL) {
+				ahead_cnt++;
+				vm_cache_put (frame);
+			}
+			inode_close (ra.inode);
+		}
+	}
+}
+
+/* Asks kworkerd for a writeback every WRITEBACK_INTERVAL ticks.
+   kworkerd cannot wait for work and for the timer at once. */
 static void
-page_cache_kworkerd (void *aux) {
+page_cache_timerd (void *aux UNUSED) {
+	for (;;) {
+		timer_sleep (WRITEBACK_INTERVAL);
+		lock_acquire (&work_lock);
+		if (!writeback_pending) {
+			writeback_pending = true;
+			sema_up (&work_sema);
+		}
+		lock_release (&work_lock);
+	}
 }
+#endif
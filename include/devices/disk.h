@@ -2,6 +2,9 @@
 #define DEVICES_DISK_H
 
 #include <inttypes.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Size of a disk sector in bytes. */
@@ -15,6 +18,34 @@ typedef uint32_t disk_sector_t;
  * printf ("sector=%"PRDSNu"\n", sector); */
 #define PRDSNu PRIu32
 
+/* Maximum number of sectors in one disk_read_multi() or
+ * disk_write_multi() transfer: the limit of the ATA sector
+ * count register. */
+#define DISK_MULTI_MAX 256
+
+extern bool disk_dma;
+
+struct disk_request;
+
+/* Called when a disk request completes.  Runs in the disk
+ * interrupt handler, so it must not sleep. */
+typedef void disk_request_func (struct disk_request *);
+
+/* An asynchronous transfer between a disk and memory, for
+ * disk_submit().  The submitter fills in the members down to
+ * AUX and keeps the request alive until DONE has been called. */
+struct disk_request {
+	struct disk *disk;          /* Disk to transfer to or from. */
+	disk_sector_t sec_no;       /* First sector. */
+	size_t cnt;                 /* Sectors, 1 to DISK_MULTI_MAX. */
+	void *buffer;               /* CNT * DISK_SECTOR_SIZE bytes. */
+	bool write;                 /* Write BUFFER to the disk? */
+	disk_request_func *done;    /* Completion callback. */
+	void *aux;                  /* For DONE's use. */
+
+	struct list_elem elem;      /* Channel queue element. */
+};
+
 void disk_init (void);
 void disk_print_stats (void);
 
@@ -22,6 +53,12 @@ struct disk *disk_get (int chan_no, int dev_no);
 disk_sector_t disk_size (struct disk *);
 void disk_read (struct disk *, disk_sector_t, void *);
 void disk_write (struct disk *, disk_sector_t, const void *);
+void disk_read_multi (struct disk *, disk_sector_t, size_t cnt, void *);
+void disk_write_multi (struct disk *, disk_sector_t, size_t cnt,
+		const void *);
+void disk_submit (struct disk_request *);
+void disk_seek_stats (struct disk *, long long *command_cnt,
+		long long *seek_sectors);
 
 void 	register_disk_inspect_intr ();
 #endif /* devices/disk.h */
@@ -1,12 +1,38 @@
 #ifndef FILESYS_PAGE_CACHE_H
 #define FILESYS_PAGE_CACHE_H
-#include "vm/vm.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include "devices/disk.h"
+#include "filesys/off_t.h"
+#include "threads/vaddr.h"
 
 struct page;
+struct inode;
 enum vm_type;
 
-struct page_cache {};
+/* Number of sectors in a page. */
+#define PAGE_CACHE_SECTORS (PGSIZE / DISK_SECTOR_SIZE)
 
-void page_cache_init (void);
+/* A page of file data in the page cache.  It is the first page of
+   its frame and belongs to no process. */
+struct page_cache {
+	disk_sector_t sectors[PAGE_CACHE_SECTORS]; /* Sectors of the data. */
+	size_t read_bytes;          /* Bytes of file data; the rest is zero. */
+	bool dirty;                 /* Not yet written back? */
+	bool accessed;              /* Used by read() or write() since the
+	                               clock hand passed? */
+};
+
+/* True once file I/O goes through the page cache. */
+extern bool page_cache_enabled;
+
+void pagecache_init (void);
 bool page_cache_initializer (struct page *page, enum vm_type type, void *kva);
+struct page *page_cache_alloc (struct inode *, off_t ofs);
+off_t page_cache_read (struct inode *, void *, off_t size, off_t offset);
+off_t page_cache_write (struct inode *, const void *, off_t size,
+		off_t offset);
+void page_cache_flush (void);
+void page_cache_drop (struct inode *);
+void page_cache_print_stats (void);
 #endif
@@ -0,0 +1,68 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Binary heap.
+ *
+ * This is a priority queue shaped as a complete binary tree
+ * whose nodes are linked by pointers instead of being stored in
+ * an array.  Like the list and hash table, the heap does not use
+ * dynamic allocation: each structure that can potentially be in
+ * a heap must embed a struct heap_elem member, and the
+ * heap_entry macro converts a struct heap_elem back to the
+ * structure that contains it.  See lib/kernel/list.h for a
+ * detailed explanation of the technique.
+ *
+ * Because nodes are linked rather than indexed, insertion,
+ * removal of the top element and removal of an arbitrary element
+ * all take O(log n) time in the worst case, and none of them
+ * ever allocates memory.  That makes the heap safe to use with
+ * interrupts disabled or from an interrupt handler. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem
+{
+	struct heap_elem *parent; /* Parent node, or NULL for the root. */
+	struct heap_elem *left;	  /* Left child. */
+	struct heap_elem *right;  /* Right child. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+ * the structure that HEAP_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER) \
+	((STRUCT *)((uint8_t *)&(HEAP_ELEM)->parent - offsetof(STRUCT, MEMBER.parent)))
+
+/* Compares the value of two heap elements A and B, given
+ * auxiliary data AUX.  Returns true if A should be closer to the
+ * top of the heap than B.  Use a "less than" function for a
+ * min-heap and a "greater than" function for a max-heap. */
+typedef bool heap_less_func(const struct heap_elem *a,
+							const struct heap_elem *b,
+							void *aux);
+
+/* Heap. */
+struct heap
+{
+	struct heap_elem *root; /* Top element, or NULL if empty. */
+	size_t size;			/* Number of elements. */
+	heap_less_func *less;	/* Comparison function. */
+	void *aux;				/* Auxiliary data for `less'. */
+};
+
+void heap_init(struct heap *, heap_less_func *, void *aux);
+
+void heap_push(struct heap *, struct heap_elem *);
+struct heap_elem *heap_top(const struct heap *);
+struct heap_elem *heap_pop(struct heap *);
+void heap_remove(struct heap *, struct heap_elem *);
+void heap_update(struct heap *, struct heap_elem *);
+
+size_t heap_size(const struct heap *);
+bool heap_empty(const struct heap *);
+
+#endif /* lib/kernel/heap.h */
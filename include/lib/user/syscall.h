@@ -58,6 +58,14 @@ static inline void* get_phys_addr (void *user_addr) {
 	return pa;
 }
 
+static inline long long
+get_page_fault_cnt (void) {
+	long long fault_cnt;
+	asm volatile ("int $0x45");
+	asm volatile ("\t movq %%rax, %0": "=r" (fault_cnt));
+	return fault_cnt;
+}
+
 static inline long long
 get_fs_disk_read_cnt (void) {
 	long long read_cnt;
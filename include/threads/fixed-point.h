@@ -0,0 +1,73 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 fixed-point real numbers, as used by the 4.4BSD
+   scheduler: 1 sign bit, 17 integer bits and 14 fraction bits
+   packed into an int.  N is an integer and X, Y are fixed-point
+   numbers in the names below. */
+typedef int fixed_t;
+
+#define FP_SHIFT 14
+#define FP_F (1 << FP_SHIFT)
+
+/* Converts N to fixed point. */
+static inline fixed_t
+int_to_fp (int n) {
+	return n * FP_F;
+}
+
+/* Converts X to an integer, rounding toward zero. */
+static inline int
+fp_to_int (fixed_t x) {
+	return x / FP_F;
+}
+
+/* Converts X to an integer, rounding to nearest. */
+static inline int
+fp_to_int_round (fixed_t x) {
+	return x >= 0 ? (x + FP_F / 2) / FP_F : (x - FP_F / 2) / FP_F;
+}
+
+static inline fixed_t
+add_fp (fixed_t x, fixed_t y) {
+	return x + y;
+}
+
+static inline fixed_t
+sub_fp (fixed_t x, fixed_t y) {
+	return x - y;
+}
+
+static inline fixed_t
+add_mixed (fixed_t x, int n) {
+	return x + n * FP_F;
+}
+
+static inline fixed_t
+sub_mixed (fixed_t x, int n) {
+	return x - n * FP_F;
+}
+
+static inline fixed_t
+mult_fp (fixed_t x, fixed_t y) {
+	return ((int64_t) x) * y / FP_F;
+}
+
+static inline fixed_t
+mult_mixed (fixed_t x, int n) {
+	return x * n;
+}
+
+static inline fixed_t
+div_fp (fixed_t x, fixed_t y) {
+	return ((int64_t) x) * FP_F / y;
+}
+
+static inline fixed_t
+div_mixed (fixed_t x, int n) {
+	return x / n;
+}
+
+#endif /* threads/fixed-point.h */
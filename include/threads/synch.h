@@ -1,6 +1,7 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
 
@@ -16,10 +17,17 @@ bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
-/* Lock. */
+/* Lock.
+
+   Waiting threads are kept in a max-heap ordered by priority, so
+   the highest-priority waiter, which is the priority the lock
+   donates to its holder, is always on top.  The holder keeps the
+   locks it holds in another max-heap ordered by that donated
+   priority. */
 struct lock {
-	struct thread *holder;      /* Thread holding lock (for debugging). */
-	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct thread *holder;      /* Thread holding lock. */
+	struct heap waiters;        /* Waiting threads. */
+	struct heap_elem elem;      /* Element in holder's held_locks. */
 };
 
 void lock_init (struct lock *);
@@ -27,10 +35,28 @@ void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+int lock_donated_priority (const struct lock *);
+bool cmp_lock_waiter (const struct heap_elem *, const struct heap_elem *, void *aux);
+bool cmp_held_lock (const struct heap_elem *, const struct heap_elem *, void *aux);
 
 /* sema compare */
 bool cmp_sema_priority (const struct list_elem  *cmp_elem, const struct list_elem  *list_elem, void *aux);
 
+/* Readers-writer lock. */
+struct rwlock {
+	struct lock writer;         /* Held by the active writer. */
+	unsigned readers;           /* Number of active readers. */
+	bool draining;              /* Writer waiting for readers to leave? */
+	struct semaphore drained;   /* Upped when the last reader leaves. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_read_acquire (struct rwlock *);
+void rwlock_read_release (struct rwlock *);
+void rwlock_write_acquire (struct rwlock *);
+void rwlock_write_release (struct rwlock *);
+bool rwlock_held_for_write (const struct rwlock *);
+
 /* Condition variable. */
 struct condition {
 	struct list waiters;        /* List of waiting threads. */
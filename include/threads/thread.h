@@ -2,8 +2,10 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
 #include <stdint.h>
+#include "threads/fixed-point.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 #ifdef VM
@@ -29,6 +31,11 @@ typedef int tid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63	   /* Highest priority. */
 
+/* Thread niceness, for the MLFQS. */
+#define NICE_MIN -20	/* Nicest. */
+#define NICE_DEFAULT 0	/* Default. */
+#define NICE_MAX 20		/* Least nice. */
+
 /* A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page.  The
@@ -94,16 +101,27 @@ struct thread
 	char name[16];			   /* Name (for debugging purposes). */
 	int priority;			   /* Priority. */
 
-	int64_t wake_up_tick; /* wake_up_tick 변수 추가하기 */
+	int64_t wake_up_tick;		  /* wake_up_tick 변수 추가하기 */
+	struct heap_elem sleep_elem; /* sleep heap element */
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem; /* List element. */
 
+	/* Owned by thread.c. */
+	struct list_elem all_elem; /* List element for all threads list. */
+
+	/* MLFQS */
+	int nice;					 /* Niceness. */
+	fixed_t recent_cpu;			 /* Recently used CPU time. */
+	bool mlfqs_dirty;			 /* In the MLFQS dirty list? */
+	struct list_elem dirty_elem; /* MLFQS dirty list element. */
+
 	/* priority donation */
 	int init_priority;
 	struct lock *wait_on_lock;		/* 현재 스레드가 기다리는 락 */
-	struct list donations;			/* 기부해준 스레드들을 담는 리스트 */
-	struct list_elem donation_elem; /* thread 구조체 변환용 */
+	struct heap_elem lock_elem;		/* wait_on_lock의 waiters heap 원소 */
+	uint64_t lock_wait_seq;			/* 같은 priority 대기자 FIFO 순서 */
+	struct heap held_locks;			/* 보유 중인 락들, donated priority 순 */
 
 	struct file *fd_table[128];
 	int max_fd;
@@ -127,6 +145,8 @@ struct thread
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
 	struct supplemental_page_table spt;
+	uint64_t page_fault_cnt;            /* Page faults taken. */
+	uint64_t fault_around_cnt;          /* Pages mapped by fault-around. */
 #endif
 
 	/* Owned by thread.c. */
@@ -143,6 +163,7 @@ void thread_init(void);
 void thread_start(void);
 
 void thread_tick(void);
+void thread_idle_catchup(int64_t cnt);
 void thread_print_stats(void);
 
 typedef void thread_func(void *aux);
@@ -162,8 +183,9 @@ void thread_sleep(int64_t until_ticks); /* 재우기 */
 void thread_awake(int64_t ticks);		/* 깨우기 */
 void update_min_awake_tick(void);		/* 제일 빨리 일어날 수 있는 스레드 */
 int64_t get_min_awake_tick(void);
-/* wake_up_tick 작은 순서대로 insert */
-bool cmp_wake_up_tick(const struct list_elem *cmp_elem, const struct list_elem *list_elem, void *aux UNUSED);
+uint64_t thread_sleep_reset_cycles(void);
+/* wake_up_tick 작은 순서대로 heap 정렬 */
+bool cmp_wake_up_tick(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED);
 
 int thread_get_priority(void);
 void thread_set_priority(int);
@@ -171,17 +193,17 @@ void thread_set_priority(int);
 /* 선점 우선순위 스케줄 */
 bool cmp_priority(const struct list_elem *cmp_elem, const struct list_elem *list_elem, void *aux UNUSED);
 void schedule_preemption(void);
+void thread_set_effective_priority(struct thread *t, int priority);
 
 /* donation */
-bool cmp_donations(const struct list_elem *cmp_elem, const struct list_elem *list_elem, void *aux);
-void donate_priority(void);
-void remove_with_lock(struct lock *lock);
-void refresh_priority(void);
+void donate_priority(struct thread *t);
+void refresh_priority(struct thread *t);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
+uint64_t thread_mlfqs_update_cycles(void);
 
 void do_iret(struct intr_frame *tf);
 
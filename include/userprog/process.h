@@ -10,5 +10,6 @@ int process_exec (void *f_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (struct thread *next);
+void process_print_stats (void);
 
 #endif /* userprog/process.h */
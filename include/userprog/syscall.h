@@ -1,6 +1,7 @@
 #include <stdbool.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "filesys/off_t.h"
 
 
 #ifndef USERPROG_SYSCALL_H
@@ -23,5 +24,9 @@ void close(int);
 int fork(const char*);
 int exec(const char*);
 int wait(int );
+#ifdef VM
+void *mmap(void *, size_t, int, int, off_t);
+void munmap(void *);
+#endif
 
 #endif /* userprog/syscall.h */
@@ -1,13 +1,21 @@
 #ifndef VM_ANON_H
 #define VM_ANON_H
+#include <stddef.h>
 #include "vm/vm.h"
 struct page;
 enum vm_type;
 
 struct anon_page {
+	size_t swap_slot;           /* Swap slot holding the page, or
+	                               SWAP_SLOT_NONE while resident. */
 };
 
+/* Swap slot index of a page that is not on the swap disk. */
+#define SWAP_SLOT_NONE ((size_t) -1)
+
 void vm_anon_init (void);
+void vm_anon_print_stats (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void anon_share_slot (struct page *dst, const struct page *src);
 
 #endif
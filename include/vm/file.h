@@ -1,12 +1,28 @@
 #ifndef VM_FILE_H
 #define VM_FILE_H
+#include <list.h>
 #include "filesys/file.h"
 #include "vm/vm.h"
 
 struct page;
 enum vm_type;
 
+/* A page of a memory-mapped file.  An uninitialized VM_FILE page
+ * carries one of these, allocated with malloc(), as its aux, and so
+ * does a VM_FILE_INIT page that is still to be read from the
+ * executable. */
 struct file_page {
+	struct file *file;          /* The mapping's own open file. */
+	off_t ofs;                  /* Offset of the page in FILE. */
+	size_t read_bytes;          /* Bytes backed by FILE; rest is zero. */
+};
+
+/* A region created by one successful mmap(). */
+struct mmap_region {
+	void *addr;                 /* First page. */
+	size_t page_cnt;            /* Number of pages. */
+	struct file *file;          /* Reopened file, closed by munmap. */
+	struct list_elem elem;      /* supplemental_page_table's mmaps. */
 };
 
 void vm_file_init (void);
@@ -14,4 +30,5 @@ bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset);
 void do_munmap (void *va);
+void do_munmap_all (void);
 #endif
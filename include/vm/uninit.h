@@ -5,6 +5,8 @@
 struct page;
 enum vm_type;
 
+/* Lazy-load callback.  AUX, if not null, must come from malloc():
+ * the callback takes ownership of it and must free it. */
 typedef bool vm_initializer (struct page *, void *aux);
 
 /* Uninitlialized page. The type for implementing the
@@ -2,6 +2,7 @@
 #define VM_VM_H
 #include <stdbool.h>
 #include "threads/palloc.h"
+#include "devices/disk.h"
 #include <hash.h>
 
 enum vm_type
@@ -22,6 +23,13 @@ enum vm_type
 	VM_MARKER_0 = (1 << 3),
 	VM_MARKER_1 = (1 << 4),
 
+	/* Marks the pages of the user stack. */
+	VM_STACK = VM_MARKER_0,
+	/* Marks anonymous pages whose initial contents are read from a
+	 * file (e.g. executable segments), which fault-around treats like
+	 * file-backed pages. */
+	VM_FILE_INIT = VM_MARKER_1,
+
 	/* DO NOT EXCEED THIS VALUE. */
 	VM_MARKER_END = (1 << 31),
 };
@@ -56,6 +64,10 @@ struct page
 	struct hash_elem p_hash_elem;
 	// vm_do_claim_page에서 writable 찾는 과정을 줄이기 위해 주가
 	int writable;
+	// 이 page를 SPT에 가진 thread. frame에 맵핑할 pml4를 찾을 때 쓴다.
+	struct thread *owner;
+	// frame->pages에 들어갈 element (COW로 frame을 공유하는 page들)
+	struct list_elem frame_elem;
 
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -75,9 +87,31 @@ struct page
 struct frame
 {
 	void *kva;
-	struct page *page;
-	// TODO : 프레임 관리 인터페이스를 구현하는 과정에서 멤버 추가
-	// Frame_Table을 해쉬 테이블이 아닌 연결 리스트로 선언할 예정이기 때문에 Table -> List
+	struct page *page;	/* One of PAGES, or NULL if PAGES is empty. */
+	struct list pages;	/* Pages mapping this frame. */
+	size_t ref_cnt;		/* Number of PAGES; more than one means the
+						   frame is shared copy-on-write. */
+	bool pinned;		/* True while being filled or torn down:
+						   the clock hand skips it. */
+	size_t io_pin_cnt;	/* Number of system calls using the frame
+						   as a user buffer, see vm_pin_buffer().
+						   Not evicted or merged while nonzero. */
+	/* File page held by the frame, if it is registered in the shared
+	 * file page table so that other mappings of the same file page
+	 * reuse it: the inode number of the file and the offset of the
+	 * page.  FILE_LISTED is false otherwise.  With EFILESYS these are
+	 * the frames of the page cache. */
+	bool file_listed;
+	disk_sector_t file_inumber;
+	off_t file_ofs;
+	struct hash_elem file_elem;
+	/* Same-page merging: checksum of the contents when the daemon
+	 * last looked, and whether the frame is listed in its table of
+	 * write-protected merge targets. */
+	uint64_t ksm_sum;
+	bool ksm_listed;
+	struct hash_elem ksm_elem;
+	// Frame_Table을 해쉬 테이블이 아닌 연결 리스트로 선언
 	// Frame_List에 들어갈 element
 	struct list_elem f_elem;
 };
@@ -104,13 +138,27 @@ struct page_operations
 /* Representation of current process's memory space.
  * We don't want to force you to obey any specific design for this struct.
  * All designs up to you for this. */
+/* A node of the radix-tree SPT.  Like a level of the x86-64 page
+ * table, it has 512 slots indexed by 9 bits of the VA; a node fills
+ * one page.  Slots of the last level point to struct page, the
+ * others to the node one level down. */
+#define SPT_SLOTS 512
+struct spt_node
+{
+	void *slots[SPT_SLOTS];
+};
+
 // spt 설계
-// 해쉬 테이블로 만들고 싶은데
-// 거기 들어가는 구조체는 { 페이지 + valid(페이지 폴트용? 필요한가?) + (해쉬 테이블로 들어가야 하니까) hash_elem }
-// va가 입력으로 들어오면, 원하는 page가 바로 딱 나오는 hash table
+// 기본은 x86-64 page table과 같은 모양의 4단계 radix tree이다.
+// va의 비트로 바로 slot을 찾으므로 조회는 항상 4번의 메모리 접근이고,
+// fork/exit 때에는 va 순서대로 훑을 수 있다.  주소 공간이 아주 듬성듬성한
+// 경우를 위해 -spt=hash로 예전의 hash table을 쓸 수 있다.
+// 두 table 모두 처음 page를 넣을 때 만든다.
 struct supplemental_page_table
 {
-	struct hash *spt_hash_table;
+	struct spt_node *root;		 /* Radix tree, or NULL. */
+	struct hash *spt_hash_table; /* Hash table under -spt=hash, or NULL. */
+	struct list mmaps;			 /* struct mmap_region, one per mmap(). */
 };
 
 #include "threads/thread.h"
@@ -123,9 +171,23 @@ struct page *spt_find_page(struct supplemental_page_table *spt,
 bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
 
+/* Pages to map ahead on a read fault (kernel option -fault-around). */
+extern size_t vm_fault_around;
+/* Maximum user stack size in bytes (kernel option -stack-limit). */
+extern size_t vm_stack_limit;
+/* Use hash tables instead of radix trees for SPTs (kernel option
+ * -spt=hash). */
+extern bool vm_spt_hash;
+/* Run the same-page merging daemon (kernel option -ksm), using at
+ * most VM_KSM_BUDGET ms of CPU per second (-ksm-budget). */
+extern bool vm_ksm;
+extern unsigned vm_ksm_budget;
+
 void vm_init(void);
+void vm_print_stats(void);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
 						 bool write, bool not_present);
+bool vm_is_stack_access(void *addr, uintptr_t rsp);
 
 #define vm_alloc_page(type, upage, writable) \
 	vm_alloc_page_with_initializer((type), (upage), (writable), NULL, NULL)
@@ -133,6 +195,15 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
 									bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page(struct page *page);
 bool vm_claim_page(void *va);
+bool vm_pin_buffer(const void *buffer, size_t size, bool write);
+void vm_unpin_buffer(const void *buffer, size_t size);
+#ifdef EFILESYS
+struct frame *vm_cache_get(struct inode *inode, off_t ofs, bool may_evict);
+void vm_cache_put(struct frame *frame);
+bool vm_cache_resident(struct inode *inode, off_t ofs);
+void vm_cache_writeback(void);
+void vm_cache_drop(struct inode *inode);
+#endif
 enum vm_type page_get_type(struct page *page);
 
 #endif /* VM_VM_H */
@@ -0,0 +1,233 @@
+/* Binary heap.
+
+   See heap.h for basic information.
+
+   The heap is a complete binary tree: if it holds N elements,
+   they occupy positions 1...N in breadth-first order, so the
+   element at position P has children at positions 2P and 2P+1.
+   The path from the root to position P is spelled by the bits
+   of P below its most significant bit, 0 meaning "go left" and 1
+   meaning "go right".  That is how we find the last node, which
+   is where insertions attach and where removals take their
+   replacement from. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *find_position(const struct heap *, size_t pos);
+static void swap_with_parent(struct heap *, struct heap_elem *);
+static void sift_up(struct heap *, struct heap_elem *);
+static void sift_down(struct heap *, struct heap_elem *);
+
+/* Initializes heap H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void heap_init(struct heap *h, heap_less_func *less, void *aux)
+{
+	ASSERT(h != NULL);
+	ASSERT(less != NULL);
+
+	h->root = NULL;
+	h->size = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts E into heap H. */
+void heap_push(struct heap *h, struct heap_elem *e)
+{
+	ASSERT(h != NULL);
+	ASSERT(e != NULL);
+
+	e->left = e->right = NULL;
+	h->size++;
+	if (h->size == 1)
+	{
+		e->parent = NULL;
+		h->root = e;
+		return;
+	}
+
+	e->parent = find_position(h, h->size / 2);
+	if (h->size % 2 == 0)
+		e->parent->left = e;
+	else
+		e->parent->right = e;
+	sift_up(h, e);
+}
+
+/* Returns the top element of H, that is, an element for which no
+   other element in H compares "less", or a null pointer if H is
+   empty. */
+struct heap_elem *
+heap_top(const struct heap *h)
+{
+	ASSERT(h != NULL);
+
+	return h->root;
+}
+
+/* Removes and returns the top element of H, or returns a null
+   pointer if H is empty. */
+struct heap_elem *
+heap_pop(struct heap *h)
+{
+	struct heap_elem *top = heap_top(h);
+
+	if (top != NULL)
+		heap_remove(h, top);
+	return top;
+}
+
+/* Removes E, which must be in heap H, from H. */
+void heap_remove(struct heap *h, struct heap_elem *e)
+{
+	struct heap_elem *last;
+
+	ASSERT(h != NULL);
+	ASSERT(e != NULL);
+	ASSERT(h->size > 0);
+
+	/* Detach the last node. */
+	last = find_position(h, h->size);
+	if (last->parent == NULL)
+		h->root = NULL;
+	else if (last->parent->left == last)
+		last->parent->left = NULL;
+	else
+		last->parent->right = NULL;
+	h->size--;
+
+	/* Put the last node where E was and restore heap order. */
+	if (last != e)
+	{
+		last->parent = e->parent;
+		last->left = e->left;
+		last->right = e->right;
+		if (last->left != NULL)
+			last->left->parent = last;
+		if (last->right != NULL)
+			last->right->parent = last;
+		if (last->parent == NULL)
+			h->root = last;
+		else if (last->parent->left == e)
+			last->parent->left = last;
+		else
+			last->parent->right = last;
+
+		sift_up(h, last);
+		sift_down(h, last);
+	}
+
+	e->parent = e->left = e->right = NULL;
+}
+
+/* Restores the heap order of H after the key of E, which must be
+   in H, has changed. */
+void heap_update(struct heap *h, struct heap_elem *e)
+{
+	ASSERT(h != NULL);
+	ASSERT(e != NULL);
+
+	sift_up(h, e);
+	sift_down(h, e);
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size(const struct heap *h)
+{
+	return h->size;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool heap_empty(const struct heap *h)
+{
+	return h->size == 0;
+}
+
+/* Returns the element at position POS, counting from 1 at the
+   root in breadth-first order.  POS must be between 1 and the
+   size of H, inclusive. */
+static struct heap_elem *
+find_position(const struct heap *h, size_t pos)
+{
+	struct heap_elem *e = h->root;
+	int bit;
+
+	ASSERT(pos >= 1 && pos <= h->size);
+
+	for (bit = 62 - __builtin_clzll(pos); bit >= 0; bit--)
+		e = (pos >> bit) & 1 ? e->right : e->left;
+	return e;
+}
+
+/* Exchanges C with its parent P in the tree of H. */
+static void
+swap_with_parent(struct heap *h, struct heap_elem *c)
+{
+	struct heap_elem *p = c->parent;
+	struct heap_elem *gp = p->parent;
+	struct heap_elem *c_left = c->left;
+	struct heap_elem *c_right = c->right;
+	struct heap_elem *sibling;
+
+	/* P's other child becomes C's child, next to P itself. */
+	if (p->left == c)
+	{
+		sibling = p->right;
+		c->left = p;
+		c->right = sibling;
+	}
+	else
+	{
+		sibling = p->left;
+		c->left = sibling;
+		c->right = p;
+	}
+	if (sibling != NULL)
+		sibling->parent = c;
+
+	/* C's old children become P's. */
+	p->left = c_left;
+	p->right = c_right;
+	if (c_left != NULL)
+		c_left->parent = p;
+	if (c_right != NULL)
+		c_right->parent = p;
+
+	/* C takes P's place under GP. */
+	p->parent = c;
+	c->parent = gp;
+	if (gp == NULL)
+		h->root = c;
+	else if (gp->left == p)
+		gp->left = c;
+	else
+		gp->right = c;
+}
+
+/* Moves E toward the root while it compares "less" than its
+   parent. */
+static void
+sift_up(struct heap *h, struct heap_elem *e)
+{
+	while (e->parent != NULL && h->less(e, e->parent, h->aux))
+		swap_with_parent(h, e);
+}
+
+/* Moves E toward the leaves while one of its children compares
+   "less" than it. */
+static void
+sift_down(struct heap *h, struct heap_elem *e)
+{
+	for (;;)
+	{
+		struct heap_elem *min = e->left;
+
+		if (e->right != NULL && (min == NULL || h->less(e->right, min, h->aux)))
+			min = e->right;
+		if (min == NULL || !h->less(min, e, h->aux))
+			break;
+		swap_with_parent(h, min);
+	}
+}
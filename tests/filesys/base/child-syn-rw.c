@@ -0,0 +1,49 @@
+/* Child process for syn-rw test.
+   Fills its own file with random data a chunk at a time, then
+   reads it back a chunk at a time and verifies it. */
+
+#include <random.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/filesys/base/syn-rw.h"
+
+static char buf[BUF_SIZE];
+
+int
+main (int argc, const char *argv[]) 
+{
+  test_name = "child-syn-rw";
+
+  char file_name[16];
+  char chunk[CHUNK_SIZE];
+  int child_idx;
+  int fd;
+  size_t ofs;
+
+  quiet = true;
+
+  CHECK (argc == 2, "argc must be 2, actually %d", argc);
+  child_idx = atoi (argv[1]);
+  snprintf (file_name, sizeof file_name, "data%d", child_idx);
+
+  random_init (child_idx);
+  random_bytes (buf, sizeof buf);
+
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  for (ofs = 0; ofs < sizeof buf; ofs += CHUNK_SIZE)
+    CHECK (write (fd, buf + ofs, CHUNK_SIZE) == CHUNK_SIZE,
+           "write \"%s\"", file_name);
+
+  seek (fd, 0);
+  for (ofs = 0; ofs < sizeof buf; ofs += CHUNK_SIZE) 
+    {
+      CHECK (read (fd, chunk, CHUNK_SIZE) == CHUNK_SIZE,
+             "read \"%s\"", file_name);
+      compare_bytes (chunk, buf + ofs, CHUNK_SIZE, ofs, file_name);
+    }
+  close (fd);
+
+  return child_idx;
+}
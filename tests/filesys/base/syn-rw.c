@@ -0,0 +1,58 @@
+/* Spawns child processes, each of which writes and then reads
+   back its own file at the same time as the others.  Runs the
+   children once with a single child and once with CHILD_CNT,
+   each child doing the same work, and reports the time stamp
+   counter cycles each run took.
+
+   With per-file locking the children's I/O overlaps, so CHILD_CNT
+   children should take no longer than CHILD_CNT runs of a single
+   child. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/filesys/base/syn-rw.h"
+
+/* Reads the time stamp counter. */
+static uint64_t
+rdtsc (void)
+{
+  uint32_t lo, hi;
+
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Starts N children at once and returns the cycles it took for
+   all of them to finish. */
+static uint64_t
+run_children (size_t n)
+{
+  pid_t children[CHILD_CNT];
+  uint64_t start = rdtsc ();
+
+  exec_children ("child-syn-rw", children, n);
+  wait_children (children, n);
+  return rdtsc () - start;
+}
+
+void
+test_main (void) 
+{
+  uint64_t one, all;
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++) 
+    {
+      char file_name[16];
+      snprintf (file_name, sizeof file_name, "data%d", i);
+      CHECK (create (file_name, BUF_SIZE), "create \"%s\"", file_name);
+    }
+
+  one = run_children (1);
+  all = run_children (CHILD_CNT);
+  msg ("1 child: %llu cycles.", (unsigned long long) one);
+  msg ("%d children: %llu cycles.", CHILD_CNT, (unsigned long long) all);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+
+my (@output) = bench_output ();
+my ($one) = bench_values (qr/^1 child: (\d+) cycles\.$/, @output);
+my ($all) = bench_values (qr/^(\d+) children: (\d+) cycles\.$/, @output);
+my ($n, $cycles) = @$all;
+
+# Each child locks only its own file, so while one child waits
+# for the disk the others keep going.  All N children together
+# must not take longer than N runs of a single child.
+fail "$n children took $cycles cycles, more than $n times the "
+  . "$one->[0] cycles of 1 child\n"
+  if $cycles > $n * $one->[0];
+pass;
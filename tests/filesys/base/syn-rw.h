@@ -0,0 +1,8 @@
+#ifndef TESTS_FILESYS_BASE_SYN_RW_H
+#define TESTS_FILESYS_BASE_SYN_RW_H
+
+#define CHILD_CNT 4
+#define BUF_SIZE 8192
+#define CHUNK_SIZE 64
+
+#endif /* tests/filesys/base/syn-rw.h */
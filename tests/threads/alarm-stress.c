@@ -0,0 +1,98 @@
+/* Runs many periodic sleepers at once and reports the average
+   time per sleep that inserting into and waking up from the
+   sleep queue kept interrupts disabled, and how many ticks late
+   the latest wakeup came.  Also verifies that no thread ever
+   wakes up before its requested tick.
+
+   The test runs once with a tenth of THREAD_CNT sleepers and
+   once with all of them.  With an ordered sleep list, insertion
+   is O(n) in the number of sleepers; with a heap, the reported
+   average should grow only logarithmically between the two
+   rounds.  Averaging over every sleep keeps a single slow
+   measurement from deciding the result. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 500
+#define ITER_CNT 10
+
+static thread_func sleeper;
+
+static void run (int thread_cnt);
+
+static struct semaphore done;
+static volatile int early_cnt;
+static volatile int64_t max_late;
+
+void
+test_alarm_stress (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  run (THREAD_CNT / 10);
+  run (THREAD_CNT);
+  pass ();
+}
+
+/* Runs THREAD_CNT sleepers to completion and reports the
+   measurements. */
+static void
+run (int thread_cnt) 
+{
+  int i;
+
+  msg ("Creating %d threads to sleep %d times each.", thread_cnt, ITER_CNT);
+
+  max_late = 0;
+  thread_sleep_reset_cycles ();
+  for (i = 0; i < thread_cnt; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper%03d", i % 1000);
+      if (thread_create (name, PRI_DEFAULT, sleeper, (void *) (intptr_t) i)
+          == TID_ERROR)
+        fail ("thread_create failed at thread %d", i);
+    }
+
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done);
+
+  if (early_cnt != 0)
+    fail ("%d wakeups happened before the requested tick", early_cnt);
+  msg ("%d threads: sleep queue kept interrupts off %llu cycles "
+       "per sleep, latest wakeup %lld ticks late",
+       thread_cnt, (unsigned long long) thread_sleep_reset_cycles (),
+       (long long) max_late);
+}
+
+/* Sleeps ITER_CNT times for a period between 1 and 17 ticks,
+   chosen from the thread's ID. */
+static void
+sleeper (void *id_) 
+{
+  int id = (intptr_t) id_;
+  int period = id % 17 + 1;
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      int64_t wake = timer_ticks () + period;
+      int64_t late;
+
+      timer_sleep (period);
+      late = timer_ticks () - wake;
+      if (late < 0)
+        early_cnt++;
+      else if (late > max_late)
+        max_late = late;
+    }
+  sema_up (&done);
+}
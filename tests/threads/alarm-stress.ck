@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+
+my (@output) = bench_output ();
+my (@runs) = bench_values (qr/^(\d+) threads: sleep queue kept interrupts off (\d+) cycles per sleep, latest wakeup (\d+) ticks late$/, @output);
+fail "expected 2 rounds, got " . scalar (@runs) . "\n" if @runs != 2;
+my ($small, $large) = @runs;
+
+# A heap makes each sleep queue operation O(log n).  Ten times as
+# many sleepers should then cost well under four times as much per
+# sleep, where an ordered list costs about ten times as much.  The
+# figures are averages over thousands of sleeps, so one slow
+# sample does not decide the outcome.
+fail "$large->[0] sleepers kept interrupts off $large->[1] cycles per "
+  . "sleep, more than four times the $small->[1] cycles with "
+  . "$small->[0]\n"
+  if $large->[1] > 4 * $small->[1];
+
+# Woken threads must get the CPU soon after their tick.
+foreach my $run (@runs) {
+    fail "with $run->[0] sleepers a wakeup came $run->[2] ticks late\n"
+      if $run->[2] > 10;
+}
+pass;
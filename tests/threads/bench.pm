@@ -0,0 +1,46 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Helpers for benchmark tests, which print the numbers they
+# measured as ordinary messages and then PASS, or end if they are
+# user programs.  The .ck file pulls the numbers out and checks
+# them against a baseline measured in the same run.
+
+# Checks that the benchmark ran to its PASS or end message and
+# returns its messages without the "(test-name) " prefix.
+sub bench_output {
+    our ($test);
+    my ($name) = $test =~ m%([^/]+)$%;
+    my (@output) = read_text_file ("$test.output");
+
+    common_checks ("run", @output);
+    @output = get_core_output ("run", @output);
+    fail "missing PASS in output"
+      unless grep ($_ eq "($name) PASS" || $_ eq "($name) end", @output);
+    return map { (my $s = $_) =~ s/^\(\Q$name\E\) //; $s } @output;
+}
+
+# Returns true if the benchmark reported that it skipped its
+# measurements, e.g. because the kernel lacks a subsystem.
+sub bench_skipped {
+    return grep (/ skipping\.$/, @_) != 0;
+}
+
+# Matches each line of @OUTPUT against $RE and returns one array
+# reference per matching line, holding the captured numbers.
+# Fails if no line matches.
+sub bench_values {
+    my ($re, @output) = @_;
+    my (@values);
+
+    foreach (@output) {
+	my (@captures) = /$re/ or next;
+	push (@values, \@captures);
+    }
+    fail "no output line matches $re\n" if !@values;
+    return @values;
+}
+
+1;
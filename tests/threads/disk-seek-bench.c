@@ -0,0 +1,106 @@
+/* Measures how well the disk request queue orders concurrent
+   random reads.
+
+   First one thread reads THREAD_CNT * READ_CNT random sectors of
+   the file system disk, one at a time, so the queue never holds
+   more than one request and the heads go wherever the next
+   sector is.  Then THREAD_CNT threads read the same sectors
+   concurrently, READ_CNT each, so the C-LOOK elevator has up to
+   THREAD_CNT requests to choose from.  Each pass reports the
+   average seek distance between disk commands, in sectors, and
+   the timer ticks it took.
+
+   The sectors are only read, never written.  Requires a kernel
+   built with FILESYS. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#ifdef FILESYS
+#include "devices/disk.h"
+#include "filesys/filesys.h"
+#endif
+
+#define THREAD_CNT 8
+#define READ_CNT 64
+
+#ifdef FILESYS
+static thread_func reader_thread;
+static void run (int thread_cnt, int read_cnt);
+static disk_sector_t pick_sector (int read);
+
+static struct semaphore done;
+static int reads_per_thread;
+#endif
+
+void
+test_disk_seek_bench (void) 
+{
+#ifdef FILESYS
+  sema_init (&done, 0);
+  run (1, THREAD_CNT * READ_CNT);
+  run (THREAD_CNT, READ_CNT);
+  pass ();
+#else
+  msg ("kernel built without FILESYS, skipping.");
+  pass ();
+#endif
+}
+
+#ifdef FILESYS
+/* Has THREAD_CNT threads each read READ_CNT sectors, and reports
+   the average seek and the ticks they took. */
+static void
+run (int thread_cnt, int read_cnt) 
+{
+  long long start_commands, start_seek, commands, seek;
+  int64_t start = timer_ticks ();
+  int64_t ticks;
+  int i;
+
+  reads_per_thread = read_cnt;
+  disk_seek_stats (filesys_disk, &start_commands, &start_seek);
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      char name[20];
+      snprintf (name, sizeof name, "reader %d", i);
+      thread_create (name, PRI_DEFAULT, reader_thread, (void *) (intptr_t) i);
+    }
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done);
+  ticks = timer_elapsed (start);
+  disk_seek_stats (filesys_disk, &commands, &seek);
+  commands -= start_commands;
+  seek -= start_seek;
+
+  msg ("%d threads, %d reads each: average seek %lld sectors, %lld ticks.",
+       thread_cnt, read_cnt, commands != 0 ? seek / commands : 0, ticks);
+}
+
+/* Returns the sector for read number READ of a pass.  Reads are
+   numbered consecutively across a pass's threads, so both passes
+   read the same sectors. */
+static disk_sector_t
+pick_sector (int read) 
+{
+  unsigned x = (unsigned) read * 2654435761u;
+
+  return (x ^ (x >> 15)) % disk_size (filesys_disk);
+}
+
+static void
+reader_thread (void *id_) 
+{
+  int id = (intptr_t) id_;
+  char buffer[DISK_SECTOR_SIZE];
+  int read;
+
+  for (read = 0; read < reads_per_thread; read++)
+    disk_read (filesys_disk,
+               pick_sector (id * reads_per_thread + read), buffer);
+  sema_up (&done);
+}
+#endif
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+
+my (@output) = bench_output ();
+pass if bench_skipped (@output);
+
+my (@runs) = bench_values (qr/^(\d+) threads, \d+ reads each: average seek (\d+) sectors, \d+ ticks\.$/,
+			   @output);
+fail "expected 2 passes, got " . scalar (@runs) . "\n" if @runs != 2;
+my ($serial, $concurrent) = @runs;
+
+# The same sectors are read in both passes.  With several
+# requests queued the elevator serves them in sector order, so
+# the heads must travel less between commands than when each
+# request is served alone.
+fail "average seek with $concurrent->[0] threads was $concurrent->[1] "
+  . "sectors, not less than $serial->[1] with $serial->[0]\n"
+  if $serial->[1] > 0 && $concurrent->[1] >= $serial->[1];
+pass;
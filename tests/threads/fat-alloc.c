@@ -0,0 +1,116 @@
+/* Checks the FAT cluster allocator and measures how the cost of
+   growing a chain changes with its length.
+
+   Grows a chain one cluster at a time, as a file written
+   sequentially would, and checks that each new cluster directly
+   follows the chain's tail on disk whenever that cluster was
+   free.  Then cuts the chain in the middle, checks that the cut
+   off clusters are free again, and grows the chain back, which
+   must reuse them in place.  Finally frees the whole chain.
+
+   Growing the chain passes only its tail to fat_create_chain(),
+   so each cluster should cost the same however long the chain
+   already is.  The test reports the average cycles per cluster
+   over the first and the last CLUSTER_BATCH clusters.
+
+   Requires a kernel built with EFILESYS and a file system disk
+   of at least 2 * CHAIN_LEN sectors, mostly free. */
+
+#include <stdio.h>
+#include <intrinsic.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#ifdef EFILESYS
+#include "devices/disk.h"
+#include "filesys/fat.h"
+#include "filesys/filesys.h"
+#endif
+
+#define CHAIN_LEN 1000
+#define CLUSTER_BATCH 100
+
+#ifdef EFILESYS
+static cluster_t chain[CHAIN_LEN];
+
+/* Adds a cluster after CHAIN[IDX - 1], or starts the chain if IDX
+   is 0, and stores it in CHAIN[IDX].  Fails the test if the new
+   cluster does not directly follow the tail although that
+   cluster was free. */
+static void
+grow (int idx)
+{
+  cluster_t tail = idx > 0 ? chain[idx - 1] : 0;
+  bool next_free = idx > 0 && fat_get (tail + 1) == 0;
+
+  chain[idx] = fat_create_chain (tail);
+  if (chain[idx] == 0)
+    fail ("fat_create_chain failed at cluster %d of %d", idx, CHAIN_LEN);
+  if (fat_get (chain[idx]) != EOChain)
+    fail ("new cluster %u does not end the chain", chain[idx]);
+  if (idx > 0 && fat_get (tail) != chain[idx])
+    fail ("cluster %u does not link to new cluster %u", tail, chain[idx]);
+  if (next_free && chain[idx] != tail + 1)
+    fail ("cluster %u was free, but the chain grew from %u to %u",
+          tail + 1, tail, chain[idx]);
+}
+
+/* Grows the chain from FROM to TO clusters and returns the
+   average cycles per cluster added. */
+static uint64_t
+grow_range (int from, int to)
+{
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = from; i < to; i++)
+    grow (i);
+  return (rdtsc () - start) / (to - from);
+}
+#endif
+
+void
+test_fat_alloc (void)
+{
+#ifdef EFILESYS
+  uint64_t first, last;
+  int cut = CHAIN_LEN / 2;
+  int i;
+
+  if (disk_size (filesys_disk) < 2 * CHAIN_LEN)
+    fail ("file system disk has %d sectors, need %d",
+          (int) disk_size (filesys_disk), 2 * CHAIN_LEN);
+
+  first = grow_range (0, CLUSTER_BATCH);
+  grow_range (CLUSTER_BATCH, CHAIN_LEN - CLUSTER_BATCH);
+  last = grow_range (CHAIN_LEN - CLUSTER_BATCH, CHAIN_LEN);
+  msg ("%d-cluster chain: first %d clusters %llu cycles each, "
+       "last %d clusters %llu cycles each.",
+       CHAIN_LEN, CLUSTER_BATCH, (unsigned long long) first,
+       CLUSTER_BATCH, (unsigned long long) last);
+
+  /* Cut the chain after CHAIN[CUT - 1]. */
+  fat_remove_chain (chain[cut], chain[cut - 1]);
+  if (fat_get (chain[cut - 1]) != EOChain)
+    fail ("cluster %u does not end the chain after the cut",
+          chain[cut - 1]);
+  for (i = cut; i < CHAIN_LEN; i++)
+    if (fat_get (chain[i]) != 0)
+      fail ("cluster %u is still in use after the cut", chain[i]);
+
+  /* The freed clusters follow the new tail, so grow() checks
+     that growing the chain back takes them again. */
+  for (i = cut; i < CHAIN_LEN; i++)
+    grow (i);
+  msg ("Cut the chain to %d clusters and grew it back.", cut);
+
+  fat_remove_chain (chain[0], 0);
+  for (i = 0; i < CHAIN_LEN; i++)
+    if (fat_get (chain[i]) != 0)
+      fail ("cluster %u is still in use after freeing the chain",
+            chain[i]);
+  pass ();
+#else
+  msg ("kernel built without EFILESYS, skipping.");
+  pass ();
+#endif
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+
+my (@output) = bench_output ();
+pass if bench_skipped (@output);
+
+my ($run) = bench_values (qr/^\d+-cluster chain: first \d+ clusters (\d+) cycles each, last \d+ clusters (\d+) cycles each\.$/,
+			  @output);
+my ($first, $last) = @$run;
+
+# Growing a chain from its tail costs the same however long the
+# chain is.  Walking the chain from its head on every call would
+# make the last clusters of a 1000-cluster chain cost many times
+# as much as the first.
+fail "adding the last clusters took $last cycles each, more than "
+  . "four times the $first cycles for the first\n"
+  if $last > 4 * $first;
+pass;
@@ -0,0 +1,81 @@
+/* Measures how the cost of opening an inode grows with the
+   number of inodes already open.
+
+   For each N, opens N distinct inodes, then opens each of them a
+   second time and reports the average cycles per open.  The
+   second open only looks the inode up in the open-inode table,
+   so it should stay flat as N grows.  All inodes are then closed
+   and the average cycles per close are reported as well.
+
+   The inodes are raw sectors of the file system disk; they are
+   only read, never written.  Requires a kernel built with
+   FILESYS and a file system disk of at least MAX_INODES
+   sectors. */
+
+#include <stdio.h>
+#include <intrinsic.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#ifdef FILESYS
+#include "devices/disk.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#endif
+
+#define MAX_INODES 2000
+
+#ifdef FILESYS
+static struct inode *inodes[MAX_INODES];
+#endif
+
+void
+test_inode_open_bench (void) 
+{
+#ifdef FILESYS
+  static const int inode_cnts[] = {10, 100, 1000, MAX_INODES};
+  size_t i;
+
+  if (disk_size (filesys_disk) < MAX_INODES)
+    fail ("file system disk has %d sectors, need %d",
+          (int) disk_size (filesys_disk), MAX_INODES);
+
+  for (i = 0; i < sizeof inode_cnts / sizeof *inode_cnts; i++) 
+    {
+      int inode_cnt = inode_cnts[i];
+      uint64_t open_cycles, reopen_cycles, close_cycles;
+      uint64_t start;
+      int j;
+
+      start = rdtsc ();
+      for (j = 0; j < inode_cnt; j++)
+        if ((inodes[j] = inode_open (j)) == NULL)
+          fail ("inode_open (%d) failed", j);
+      open_cycles = rdtsc () - start;
+
+      start = rdtsc ();
+      for (j = 0; j < inode_cnt; j++)
+        if (inode_open (j) != inodes[j])
+          fail ("second inode_open (%d) returned a different inode", j);
+      reopen_cycles = rdtsc () - start;
+
+      start = rdtsc ();
+      for (j = 0; j < inode_cnt; j++) 
+        {
+          inode_close (inodes[j]);
+          inode_close (inodes[j]);
+        }
+      close_cycles = rdtsc () - start;
+
+      msg ("%d inodes: open %llu, reopen %llu, close %llu cycles each.",
+           inode_cnt,
+           (unsigned long long) (open_cycles / inode_cnt),
+           (unsigned long long) (reopen_cycles / inode_cnt),
+           (unsigned long long) (close_cycles / (2 * inode_cnt)));
+    }
+  pass ();
+#else
+  msg ("kernel built without FILESYS, skipping.");
+  pass ();
+#endif
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+
+my (@output) = bench_output ();
+pass if bench_skipped (@output);
+
+my (%reopen) = map (($_->[0] => $_->[1]),
+		    bench_values (qr/^(\d+) inodes: open \d+, reopen (\d+), close \d+ cycles each\.$/,
+				  @output));
+fail "missing 100 or 2000 inode results\n"
+  if !defined $reopen{100} || !defined $reopen{2000};
+
+# Reopening only looks the inode up in the open-inode table.  A
+# hash table keeps that flat, where a list scan would cost twenty
+# times as much with twenty times the inodes.
+fail "reopen with 2000 open inodes took $reopen{2000} cycles, more "
+  . "than four times the $reopen{100} cycles with 100\n"
+  if $reopen{2000} > 4 * $reopen{100};
+pass;
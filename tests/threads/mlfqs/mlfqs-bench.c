@@ -0,0 +1,64 @@
+/* Measures the cost of the once-per-second MLFQS update of
+   load_avg and recent_cpu as the number of threads grows.
+
+   Each round creates N threads that immediately block on a
+   semaphore, waits a couple of seconds so that the update runs
+   with all of them in the system, and reports the number of CPU
+   cycles the last update took.  Priorities are only recalculated
+   for threads whose recent_cpu actually changed, so the cost
+   should be dominated by the single pass over all threads. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func block_thread;
+
+static struct semaphore release;
+static struct semaphore done;
+
+void
+test_mlfqs_bench (void) 
+{
+  static const int thread_cnts[] = {10, 100, 500};
+  size_t i;
+
+  ASSERT (thread_mlfqs);
+
+  sema_init (&release, 0);
+  sema_init (&done, 0);
+
+  for (i = 0; i < sizeof thread_cnts / sizeof *thread_cnts; i++) 
+    {
+      int thread_cnt = thread_cnts[i];
+      int j;
+
+      for (j = 0; j < thread_cnt; j++) 
+        {
+          char name[16];
+          snprintf (name, sizeof name, "block%03d", j % 1000);
+          thread_create (name, PRI_DEFAULT, block_thread, NULL);
+        }
+
+      timer_sleep (2 * TIMER_FREQ);
+      msg ("%d threads: per-second update took %llu cycles.",
+           thread_cnt, (unsigned long long) thread_mlfqs_update_cycles ());
+
+      for (j = 0; j < thread_cnt; j++)
+        sema_up (&release);
+      for (j = 0; j < thread_cnt; j++)
+        sema_down (&done);
+    }
+
+  pass ();
+}
+
+static void
+block_thread (void *aux UNUSED) 
+{
+  sema_down (&release);
+  sema_up (&done);
+}
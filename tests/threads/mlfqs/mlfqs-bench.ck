@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+
+my (@output) = bench_output ();
+my (%cycles) = map (($_->[0] => $_->[1]),
+		    bench_values (qr/^(\d+) threads: per-second update took (\d+) cycles\.$/,
+				  @output));
+fail "missing 100 or 500 thread results\n"
+  if !defined $cycles{100} || !defined $cycles{500};
+
+# The update is a single pass over all threads, so its cost per
+# thread must not grow with the number of threads.  Allow twice
+# the per-thread cost of the 100-thread round.
+fail "update with 500 threads took $cycles{500} cycles, more than "
+  . "twice the per-thread cost of $cycles{100} cycles with 100\n"
+  if $cycles{500} / 500 > 2 * $cycles{100} / 100;
+pass;
@@ -0,0 +1,156 @@
+/* Stresses priority donation with deep lock chains and with
+   hundreds of threads waiting on a single lock.
+
+   First, the main thread holds lock 0 while DEPTH threads form a
+   chain in which thread I holds lock I and waits on lock I - 1.
+   A high-priority thread then waits on the last lock, and its
+   priority must reach the main thread through the whole chain.
+   The test reports how many CPU cycles that donation took, for
+   a chain of CHAIN_DEPTH / 4 threads and one of CHAIN_DEPTH.
+
+   Second, the main thread holds a lock on which WAITER_CNT
+   threads of varying priority block.  The main thread must run
+   at the highest waiting priority, and after it releases the
+   lock the waiters must acquire it in order of priority.  The
+   test reports the cycles spent releasing the lock until every
+   waiter has had it, for WAITER_CNT / 10 waiters and for
+   WAITER_CNT. */
+
+#include <stdio.h>
+#include <intrinsic.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define CHAIN_DEPTH 16
+#define WAITER_CNT 300
+
+static void chain (int depth);
+static void storm (int waiter_cnt);
+static thread_func chain_thread;
+static thread_func top_thread;
+static thread_func waiter_thread;
+
+static struct lock chain_locks[CHAIN_DEPTH + 1];
+static volatile uint64_t donate_start;
+
+static struct lock storm_lock;
+static int acquire_order[WAITER_CNT];
+static int acquire_cnt;
+
+void
+test_priority_donate_stress (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  chain (CHAIN_DEPTH / 4);
+  chain (CHAIN_DEPTH);
+  storm (WAITER_CNT / 10);
+  storm (WAITER_CNT);
+  pass ();
+}
+
+/* Donates through a chain of DEPTH threads. */
+static void
+chain (int depth) 
+{
+  uint64_t cycles;
+  int i;
+
+  for (i = 0; i <= depth; i++)
+    lock_init (&chain_locks[i]);
+  lock_acquire (&chain_locks[0]);
+  for (i = 1; i <= depth; i++) 
+    {
+      char name[20];
+      snprintf (name, sizeof name, "chain %d", i);
+      thread_create (name, PRI_DEFAULT + i, chain_thread, &chain_locks[i]);
+    }
+  thread_create ("top", PRI_MAX, top_thread, &chain_locks[depth]);
+  cycles = rdtsc () - donate_start;
+  if (thread_get_priority () != PRI_MAX)
+    fail ("main thread priority is %d after %d-deep donation, "
+          "should be %d", thread_get_priority (), depth, PRI_MAX);
+  msg ("%d-deep donation took %llu cycles.",
+       depth, (unsigned long long) cycles);
+  lock_release (&chain_locks[0]);
+  if (thread_get_priority () != PRI_DEFAULT)
+    fail ("main thread priority is %d after release, should be %d",
+          thread_get_priority (), PRI_DEFAULT);
+}
+
+/* Releases a lock that WAITER_CNT threads are waiting on. */
+static void
+storm (int waiter_cnt) 
+{
+  uint64_t cycles;
+  int i;
+
+  lock_init (&storm_lock);
+  lock_acquire (&storm_lock);
+  acquire_cnt = 0;
+  for (i = 0; i < waiter_cnt; i++) 
+    {
+      char name[20];
+      snprintf (name, sizeof name, "waiter %d", i);
+      thread_create (name, PRI_DEFAULT + 1 + i * 7 % (PRI_MAX - PRI_DEFAULT),
+                     waiter_thread, NULL);
+    }
+
+  /* Waiters created below our donated priority have not run yet.
+     Sleep so that all of them queue up on the lock. */
+  timer_sleep (10);
+  if (thread_get_priority () != PRI_MAX)
+    fail ("main thread priority is %d with %d waiters, should be %d",
+          thread_get_priority (), waiter_cnt, PRI_MAX);
+
+  cycles = rdtsc ();
+  lock_release (&storm_lock);
+  cycles = rdtsc () - cycles;
+  msg ("releasing a lock with %d waiters took %llu cycles.",
+       waiter_cnt, (unsigned long long) cycles);
+
+  if (acquire_cnt != waiter_cnt)
+    fail ("only %d of %d waiters acquired the lock", acquire_cnt, waiter_cnt);
+  for (i = 1; i < waiter_cnt; i++)
+    if (acquire_order[i] > acquire_order[i - 1])
+      fail ("waiter with priority %d acquired the lock after one "
+            "with priority %d", acquire_order[i], acquire_order[i - 1]);
+}
+
+/* Holds LOCK_ and waits on the previous lock in the chain. */
+static void
+chain_thread (void *lock_) 
+{
+  struct lock *lock = lock_;
+
+  lock_acquire (lock);
+  lock_acquire (lock - 1);
+  lock_release (lock - 1);
+  lock_release (lock);
+}
+
+/* Waits on LOCK_, the last lock of the chain. */
+static void
+top_thread (void *lock_) 
+{
+  struct lock *lock = lock_;
+
+  donate_start = rdtsc ();
+  lock_acquire (lock);
+  lock_release (lock);
+}
+
+static void
+waiter_thread (void *aux UNUSED) 
+{
+  lock_acquire (&storm_lock);
+  acquire_order[acquire_cnt++] = thread_get_priority ();
+  lock_release (&storm_lock);
+}
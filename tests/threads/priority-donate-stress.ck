@@ -0,0 +1,31 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+
+my (@output) = bench_output ();
+my (%donate) = map (($_->[0] => $_->[1]),
+		    bench_values (qr/^(\d+)-deep donation took (\d+) cycles\.$/,
+				  @output));
+my (%release) = map (($_->[0] => $_->[1]),
+		     bench_values (qr/^releasing a lock with (\d+) waiters took (\d+) cycles\.$/,
+				   @output));
+fail "missing 4 or 16-deep donation\n"
+  if !defined $donate{4} || !defined $donate{16};
+fail "missing 30 or 300 waiter release\n"
+  if !defined $release{30} || !defined $release{300};
+
+# Donation walks the chain once, so each level costs about the
+# same however deep the chain is.
+fail "16-deep donation took $donate{16} cycles, more than twice the "
+  . "per-level cost of $donate{4} cycles at depth 4\n"
+  if $donate{16} / 16 > 2 * $donate{4} / 4;
+
+# With waiters kept in a heap, handing the lock to each of them
+# costs O(log n).  A sorted list makes it O(n), ten times as much
+# per waiter with ten times the waiters.
+fail "releasing to 300 waiters took $release{300} cycles, more than "
+  . "four times the per-waiter cost of $release{30} cycles with 30\n"
+  if $release{300} / 300 > 4 * $release{30} / 30;
+pass;
@@ -0,0 +1,140 @@
+/* Compares a readers-writer lock with a plain lock protecting
+   the same read-mostly data.
+
+   THREAD_CNT threads each perform OP_CNT operations on a shared
+   pair of counters, 90% reads and 10% writes.  Writers
+   increment both counters; readers check that they are equal.
+   Every operation yields the CPU inside its critical section,
+   as if it had been preempted there, so readers that hold the
+   lock concurrently are what make the rwlock faster.  The test
+   reports the timer ticks each lock took. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 8
+#define OP_CNT 1000
+#define WRITE_PERCENT 10
+
+static thread_func lock_thread;
+static thread_func rwlock_thread;
+static int64_t run (thread_func *);
+
+static struct lock lock;
+static struct rwlock rwlock;
+static struct semaphore done;
+static volatile int counter_a, counter_b;
+static volatile int mismatch_cnt;
+
+void
+test_rwlock_bench (void) 
+{
+  int64_t lock_ticks, rwlock_ticks;
+
+  lock_init (&lock);
+  rwlock_init (&rwlock);
+  sema_init (&done, 0);
+
+  lock_ticks = run (lock_thread);
+  msg ("lock: %d threads, %d%% writes: %lld ticks.",
+       THREAD_CNT, WRITE_PERCENT, lock_ticks);
+  rwlock_ticks = run (rwlock_thread);
+  msg ("rwlock: %d threads, %d%% writes: %lld ticks.",
+       THREAD_CNT, WRITE_PERCENT, rwlock_ticks);
+
+  if (mismatch_cnt != 0)
+    fail ("readers saw %d inconsistent states", mismatch_cnt);
+  if (counter_a != 2 * THREAD_CNT * OP_CNT * WRITE_PERCENT / 100)
+    fail ("counter is %d, should be %d", counter_a,
+          2 * THREAD_CNT * OP_CNT * WRITE_PERCENT / 100);
+  pass ();
+}
+
+/* Runs THREAD_CNT copies of FUNC and returns the ticks they
+   took to finish. */
+static int64_t
+run (thread_func *func) 
+{
+  int64_t start = timer_ticks ();
+  int i;
+
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "worker %d", i);
+      thread_create (name, PRI_DEFAULT, func, (void *) (intptr_t) i);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  return timer_elapsed (start);
+}
+
+/* Returns true if operation OP of thread ID is a write. */
+static bool
+is_write (int id, int op) 
+{
+  return (op * 7 + id) % 100 < WRITE_PERCENT;
+}
+
+/* Reads the counters, yielding in between. */
+static void
+do_read (void) 
+{
+  int a = counter_a;
+  thread_yield ();
+  if (a != counter_b)
+    mismatch_cnt++;
+}
+
+/* Increments the counters, yielding in between. */
+static void
+do_write (void) 
+{
+  counter_a++;
+  thread_yield ();
+  counter_b++;
+}
+
+static void
+lock_thread (void *id_) 
+{
+  int id = (intptr_t) id_;
+  int op;
+
+  for (op = 0; op < OP_CNT; op++) 
+    {
+      lock_acquire (&lock);
+      if (is_write (id, op))
+        do_write ();
+      else
+        do_read ();
+      lock_release (&lock);
+    }
+  sema_up (&done);
+}
+
+static void
+rwlock_thread (void *id_) 
+{
+  int id = (intptr_t) id_;
+  int op;
+
+  for (op = 0; op < OP_CNT; op++)
+    if (is_write (id, op)) 
+      {
+        rwlock_write_acquire (&rwlock);
+        do_write ();
+        rwlock_write_release (&rwlock);
+      }
+    else 
+      {
+        rwlock_read_acquire (&rwlock);
+        do_read ();
+        rwlock_read_release (&rwlock);
+      }
+  sema_up (&done);
+}
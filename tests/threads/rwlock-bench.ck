@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+
+my (@output) = bench_output ();
+my ($lock) = bench_values (qr/^lock: \d+ threads, \d+% writes: (\d+) ticks\.$/,
+			   @output);
+my ($rwlock) = bench_values (qr/^rwlock: \d+ threads, \d+% writes: (\d+) ticks\.$/,
+			     @output);
+
+# Readers hold the rwlock concurrently across the yield in their
+# critical sections, so the read-mostly workload must finish
+# sooner than under a plain lock.
+fail "rwlock took $rwlock->[0] ticks, no faster than the "
+  . "$lock->[0] ticks of a plain lock\n"
+  if $rwlock->[0] >= $lock->[0];
+pass;
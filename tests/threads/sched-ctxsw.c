@@ -0,0 +1,82 @@
+/* Measures how many context switches per second the scheduler
+   sustains as the number of runnable threads grows.
+
+   Each round creates N threads at the same priority that do
+   nothing but call thread_yield(), lets them run for
+   ROUND_TICKS timer ticks, and reports the number of yields
+   per second.  With a sorted ready list every yield costs O(N);
+   with per-priority run queues the rate should stay roughly
+   flat as N grows. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ROUND_TICKS 100
+
+static thread_func yield_thread;
+
+static volatile bool stop;
+static volatile int64_t switch_cnt;
+static struct semaphore done;
+
+void
+test_sched_ctxsw (void) 
+{
+  static const int thread_cnts[] = {1, 8, 64, 256};
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Run above the yielding threads so that we get the CPU back
+     as soon as our sleep ends. */
+  thread_set_priority (PRI_DEFAULT + 1);
+  sema_init (&done, 0);
+
+  for (i = 0; i < sizeof thread_cnts / sizeof *thread_cnts; i++)
+    {
+      int thread_cnt = thread_cnts[i];
+      int64_t start, elapsed;
+      int j;
+
+      stop = false;
+      switch_cnt = 0;
+      for (j = 0; j < thread_cnt; j++)
+        {
+          char name[16];
+          snprintf (name, sizeof name, "yield%03d", j % 1000);
+          if (thread_create (name, PRI_DEFAULT, yield_thread, NULL)
+              == TID_ERROR)
+            fail ("thread_create failed at thread %d", j);
+        }
+
+      start = timer_ticks ();
+      timer_sleep (ROUND_TICKS);
+      stop = true;
+      elapsed = timer_elapsed (start);
+
+      msg ("%d threads: %lld context switches/s", thread_cnt,
+           switch_cnt * TIMER_FREQ / (elapsed > 0 ? elapsed : 1));
+
+      for (j = 0; j < thread_cnt; j++)
+        sema_down (&done);
+    }
+
+  thread_set_priority (PRI_DEFAULT);
+  pass ();
+}
+
+static void
+yield_thread (void *aux UNUSED) 
+{
+  while (!stop)
+    {
+      switch_cnt++;
+      thread_yield ();
+    }
+  sema_up (&done);
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::bench;
+
+my (@output) = bench_output ();
+my (%rate) = map (($_->[0] => $_->[1]),
+		  bench_values (qr/^(\d+) threads: (\d+) context switches\/s$/,
+				@output));
+
+# With O(1) run queue operations the switch rate stays roughly
+# flat as runnable threads are added.  A sorted ready list makes
+# each yield O(N), which at 256 threads costs far more than a
+# factor of three.
+fail "missing 8 or 256 thread results\n"
+  if !defined $rate{8} || !defined $rate{256};
+fail "$rate{256} switches/s with 256 threads is less than a third "
+  . "of $rate{8}/s with 8 threads\n"
+  if $rate{256} * 3 < $rate{8};
+pass;
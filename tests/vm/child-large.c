@@ -0,0 +1,28 @@
+/* Child process run by exec-large.
+   Carries about 2 MB of initialized data but touches only a
+   handful of its pages, so with lazy loading exec should read
+   just those pages from the executable. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/vm/large.inc"
+
+#define PAGE_SIZE 4096
+#define TOUCH_CNT 4
+
+int
+main (void)
+{
+  const char *lorem = "Lorem ipsum";
+  size_t stride = sizeof large / TOUCH_CNT;
+  size_t i;
+  int sum = 0;
+
+  test_name = "child-large";
+
+  if (memcmp (large, lorem, strlen (lorem)))
+    fail ("wrong data at start of large");
+  for (i = 0; i < TOUCH_CNT; i++)
+    sum += large[i * stride];
+  return sum == 0 ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-fork-exec) begin
+(child-simple) run
+(child-simple) run
+(child-simple) run
+(child-simple) run
+(child-simple) run
+(child-simple) run
+(child-simple) run
+(child-simple) run
+(cow-fork-exec) end
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Reads a file into a buffer that a forked child shares with its
+   parent copy-on-write.  The kernel's write must break the sharing,
+   so the parent still sees its own data afterward. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/large.inc"
+#include "tests/vm/sample.inc"
+
+void
+test_main (void)
+{
+	const char *buf = "Lorem ipsum";
+	pid_t child;
+	int handle;
+
+	CHECK (memcmp (buf, large, strlen (buf)) == 0, "check data consistency");
+
+	child = fork ("child");
+	if (child == 0) {
+		CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+		CHECK (read (handle, large, sizeof sample - 1) == sizeof sample - 1,
+			   "read \"sample.txt\"");
+		CHECK (memcmp (sample, large, sizeof sample - 1) == 0,
+			   "check data change");
+		close (handle);
+		return;
+	}
+	wait (child);
+	CHECK (memcmp (buf, large, strlen (buf)) == 0, "check data consistency");
+	return;
+}
@@ -0,0 +1,30 @@
+/* Repeatedly forks and execs child-large, a binary with about
+   2 MB of initialized data of which only a few pages are ever
+   touched.  With lazy loading the cost of each exec is
+   proportional to those pages rather than to the size of the
+   binary; compare the "Exec:" statistics printed at power-off
+   against a kernel that loads segments eagerly. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define EXEC_CNT 4
+
+void
+test_main (void)
+{
+  int i;
+
+  for (i = 0; i < EXEC_CNT; i++)
+    {
+      pid_t child = fork ("child-large");
+      if (child == 0)
+        exec ("child-large");
+      if (child < 0)
+        fail ("fork #%d failed", i);
+      if (wait (child) != 0)
+        fail ("child-large #%d failed", i);
+    }
+  msg ("exec'd child-large %d times", EXEC_CNT);
+}
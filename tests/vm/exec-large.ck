@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(exec-large) begin
+(exec-large) exec'd child-large 4 times
+(exec-large) end
+EOF
+pass;
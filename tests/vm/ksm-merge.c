@@ -0,0 +1,53 @@
+/* Fills several pages with the same contents and waits for the
+   same-page merging daemon to map them to one frame, then writes
+   to one of them, and read()s a file into another, and checks that
+   each write is private to its page. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 8
+#define MAX_SPINS (1 << 20)
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  volatile char *page = buf;
+  size_t i;
+  int spins;
+  int handle;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    memset (buf + i * PAGE_SIZE, 0x5a, PAGE_SIZE);
+
+  for (spins = 0; spins < MAX_SPINS; spins++)
+    {
+      if (get_phys_addr (buf) == get_phys_addr (buf + PAGE_SIZE)
+          && get_phys_addr (buf) == get_phys_addr (buf + 2 * PAGE_SIZE))
+        break;
+      for (i = 0; i < PAGE_SIZE; i++)
+        (void) page[i];
+    }
+  CHECK (spins < MAX_SPINS, "identical pages merged");
+
+  buf[PAGE_SIZE] = 0;
+  CHECK (get_phys_addr (buf) != get_phys_addr (buf + PAGE_SIZE),
+         "write gave the page its own frame");
+  CHECK (buf[0] == 0x5a && buf[PAGE_SIZE] == 0 && buf[PAGE_SIZE + 1] == 0x5a,
+         "contents are intact");
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (read (handle, buf + 2 * PAGE_SIZE, 16) == 16,
+         "read \"sample.txt\" into a merged page");
+  close (handle);
+  CHECK (get_phys_addr (buf) != get_phys_addr (buf + 2 * PAGE_SIZE),
+         "read() gave the page its own frame");
+  for (i = 0; i < 16; i++)
+    if (buf[i] != 0x5a)
+      fail ("merged frame was written by read()");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(ksm-merge) begin
+(ksm-merge) identical pages merged
+(ksm-merge) write gave the page its own frame
+(ksm-merge) contents are intact
+(ksm-merge) open "sample.txt"
+(ksm-merge) read "sample.txt" into a merged page
+(ksm-merge) read() gave the page its own frame
+(ksm-merge) end
+EOF
+pass;
@@ -0,0 +1,28 @@
+/* Reads the first byte of each of 64 consecutive pages of a large
+   initialized array, which is loaded lazily from the executable.
+   With fault-around the kernel maps the following pages on each
+   read fault, so the scan must take fewer faults than pages. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/large.inc"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 64
+
+void
+test_main (void)
+{
+  long long faults;
+  int sum = 0;
+  int i;
+
+  faults = get_page_fault_cnt ();
+  for (i = 0; i < PAGE_CNT; i++)
+    sum += large[i * PAGE_SIZE];
+  faults = get_page_fault_cnt () - faults;
+
+  CHECK (sum != 0, "read %d pages", PAGE_CNT);
+  CHECK (faults < PAGE_CNT, "took fewer faults than pages");
+}
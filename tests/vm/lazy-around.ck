@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(lazy-around) begin
+(lazy-around) read 64 pages
+(lazy-around) took fewer faults than pages
+(lazy-around) end
+EOF
+pass;
@@ -0,0 +1,44 @@
+/* Reads a file into a mapping of the same file region that has
+   not been touched yet, then reads the test's own executable into
+   a data page that has not been loaded yet.  Each read() copies
+   into a page whose contents come from the very file being read,
+   so the kernel must not fault that page in while it holds the
+   file's locks. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Initialized, so that it lives in the executable's data segment
+   and is loaded from the file on first access. */
+static char data[4096] = {1};
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  size_t len = strlen (sample);
+  int map_handle, handle;
+
+  CHECK ((map_handle = open ("sample.txt")) > 1,
+         "open \"sample.txt\" for mmap");
+  CHECK (mmap (actual, 4096, 1, map_handle, 0) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\" for read");
+  CHECK (read (handle, actual, len) == (int) len,
+         "read \"sample.txt\" into its own mapping");
+  if (memcmp (actual, sample, len))
+    fail ("mapping holds bad data after read");
+  munmap (actual);
+  close (handle);
+  close (map_handle);
+
+  CHECK ((handle = open ("mmap-read-self")) > 1, "open \"mmap-read-self\"");
+  CHECK (read (handle, data, sizeof data) == (int) sizeof data,
+         "read \"mmap-read-self\" into its data segment");
+  if (memcmp (data, "\177ELF", 4))
+    fail ("data segment holds bad data after read");
+  close (handle);
+}
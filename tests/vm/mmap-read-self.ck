@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-read-self) begin
+(mmap-read-self) open "sample.txt" for mmap
+(mmap-read-self) mmap "sample.txt"
+(mmap-read-self) open "sample.txt" for read
+(mmap-read-self) read "sample.txt" into its own mapping
+(mmap-read-self) open "mmap-read-self"
+(mmap-read-self) read "mmap-read-self" into its data segment
+(mmap-read-self) end
+EOF
+pass;
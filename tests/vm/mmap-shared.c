@@ -0,0 +1,47 @@
+/* Maps the same file into memory twice, writes through one
+   mapping, and verifies that the other mapping sees the write at
+   once, because both map the same frame, and that the write reaches
+   the file after unmapping. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static const char overwrite[] = "shared file pages";
+
+void
+test_main (void)
+{
+  char *actual[2] = {(char *) 0x10000000, (char *) 0x20000000};
+  char buf[sizeof overwrite];
+  size_t i;
+  int handle[2];
+
+  for (i = 0; i < 2; i++)
+    {
+      CHECK ((handle[i] = open ("sample.txt")) > 1,
+             "open \"sample.txt\" #%zu", i);
+      CHECK (mmap (actual[i], 4096, 1, handle[i], 0) != MAP_FAILED,
+             "mmap \"sample.txt\" #%zu at %p", i, (void *) actual[i]);
+    }
+
+  CHECK (!memcmp (actual[1], sample, strlen (sample)),
+         "compare mmap'd file 1 against data");
+  memcpy (actual[0], overwrite, sizeof overwrite);
+  CHECK (!memcmp (actual[1], overwrite, sizeof overwrite),
+         "write through mapping 0 is visible through mapping 1");
+
+  for (i = 0; i < 2; i++)
+    {
+      munmap (actual[i]);
+      close (handle[i]);
+    }
+
+  CHECK ((handle[0] = open ("sample.txt")) > 1, "reopen \"sample.txt\"");
+  CHECK (read (handle[0], buf, sizeof buf) == (int) sizeof buf,
+         "read \"sample.txt\"");
+  CHECK (!memcmp (buf, overwrite, sizeof overwrite),
+         "write was written back to the file");
+}
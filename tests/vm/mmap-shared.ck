@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-shared) begin
+(mmap-shared) open "sample.txt" #0
+(mmap-shared) mmap "sample.txt" #0 at 0x10000000
+(mmap-shared) open "sample.txt" #1
+(mmap-shared) mmap "sample.txt" #1 at 0x20000000
+(mmap-shared) compare mmap'd file 1 against data
+(mmap-shared) write through mapping 0 is visible through mapping 1
+(mmap-shared) reopen "sample.txt"
+(mmap-shared) read "sample.txt"
+(mmap-shared) write was written back to the file
+(mmap-shared) end
+EOF
+pass;
@@ -0,0 +1,35 @@
+/* Writes a file from a mapping of the same file region that has
+   not been touched yet.  write() copies out of the mapping while
+   it holds the file's inode for writing, so the kernel must not
+   fault the mapping in from that inode meanwhile. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  size_t len = strlen (sample);
+  char buf[1024];
+  int map_handle, handle;
+
+  CHECK ((map_handle = open ("sample.txt")) > 1,
+         "open \"sample.txt\" for mmap");
+  CHECK (mmap (actual, 4096, 0, map_handle, 0) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\" for write");
+  CHECK (write (handle, actual, len) == (int) len,
+         "write \"sample.txt\" from its own mapping");
+  munmap (actual);
+  close (map_handle);
+
+  seek (handle, 0);
+  CHECK (read (handle, buf, len) == (int) len, "read \"sample.txt\"");
+  if (memcmp (buf, sample, len))
+    fail ("file holds bad data after write");
+  close (handle);
+}
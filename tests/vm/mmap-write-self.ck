@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-write-self) begin
+(mmap-write-self) open "sample.txt" for mmap
+(mmap-write-self) mmap "sample.txt"
+(mmap-write-self) open "sample.txt" for write
+(mmap-write-self) write "sample.txt" from its own mapping
+(mmap-write-self) read "sample.txt"
+(mmap-write-self) end
+EOF
+pass;
@@ -0,0 +1,40 @@
+/* Maps 100,000 pages, far more than fit in memory, and reads one
+   page in every 97, so that each read takes a fault whose handling
+   starts with a lookup in a large supplemental page table.  The
+   kernel reports the cycles spent per fault with its VM statistics;
+   run with -spt=hash to compare against the hash table. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 100000
+#define STRIDE 97
+
+void
+test_main (void)
+{
+  char *map = (char *) 0x10000000;
+  long long faults;
+  size_t i;
+  int handle;
+  int sum = 0;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (map, (size_t) PAGE_CNT * PAGE_SIZE, 0, handle, 0) != MAP_FAILED,
+         "mmap %d pages", PAGE_CNT);
+
+  faults = get_page_fault_cnt ();
+  for (i = STRIDE; i < PAGE_CNT; i += STRIDE)
+    sum += map[i * PAGE_SIZE];
+  faults = get_page_fault_cnt () - faults;
+
+  CHECK (sum == 0, "read every %dth page past the end of the file", STRIDE);
+  CHECK (faults == (PAGE_CNT - 1) / STRIDE, "took one fault per page");
+  CHECK (!memcmp (map, sample, strlen (sample)),
+         "compare first page against data");
+  munmap (map);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(spt-100k) begin
+(spt-100k) open "sample.txt"
+(spt-100k) mmap 100000 pages
+(spt-100k) read every 97th page past the end of the file
+(spt-100k) took one fault per page
+(spt-100k) compare first page against data
+(spt-100k) end
+EOF
+pass;
@@ -0,0 +1,43 @@
+/* Recurses deeply with a 12 kB frame whose lowest byte is written
+   first, so that each call faults three pages below the current
+   stack bottom.  Growing the stack must map the pages in between
+   in the same fault, so the recursion takes fewer faults than the
+   pages it touches.  The kernel reports the cycles spent growing
+   stacks with its VM statistics. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define FRAME_PAGES 3
+#define DEPTH 64
+
+static int
+recurse (int depth)
+{
+  volatile char frame[FRAME_PAGES * PAGE_SIZE];
+  int i;
+
+  frame[0] = depth;
+  for (i = FRAME_PAGES * PAGE_SIZE - 1; i > 0; i -= PAGE_SIZE)
+    frame[i] = depth;
+  if (depth == 0)
+    return frame[0];
+  return recurse (depth - 1) + frame[FRAME_PAGES * PAGE_SIZE - 1];
+}
+
+void
+test_main (void)
+{
+  long long faults;
+  int sum;
+
+  faults = get_page_fault_cnt ();
+  sum = recurse (DEPTH);
+  faults = get_page_fault_cnt () - faults;
+
+  CHECK (sum == DEPTH * (DEPTH + 1) / 2, "recursed %d levels", DEPTH);
+  CHECK (faults < DEPTH * FRAME_PAGES, "took fewer faults than pages");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(stack-deep) begin
+(stack-deep) recursed 64 levels
+(stack-deep) took fewer faults than pages
+(stack-deep) end
+EOF
+pass;
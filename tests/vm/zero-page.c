@@ -0,0 +1,44 @@
+/* Reads every page of a 16 MB zero-initialized array, more than
+   fits in memory and swap together, then writes a few pages and
+   reads them back.  Pages that are only read must share the
+   kernel's zero frame instead of each taking a frame of its own.
+   Finally read()s a file into one of the shared pages, which must
+   not change the others. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 4096
+#define WRITE_STRIDE 256
+
+static char zeros[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+  int sum = 0;
+  int handle;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    sum += zeros[i * PAGE_SIZE];
+  CHECK (sum == 0, "read %d zero pages", PAGE_CNT);
+
+  for (i = 0; i < PAGE_CNT; i += WRITE_STRIDE)
+    zeros[i * PAGE_SIZE + 1] = (char) (i / WRITE_STRIDE + 1);
+  for (i = 0; i < PAGE_CNT; i++)
+    sum += zeros[i * PAGE_SIZE + 1];
+  CHECK (sum == (PAGE_CNT / WRITE_STRIDE) * (PAGE_CNT / WRITE_STRIDE + 1) / 2,
+         "wrote every %dth page", WRITE_STRIDE);
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (read (handle, zeros + PAGE_SIZE, 64) == 64,
+         "read \"sample.txt\" into a zero page");
+  close (handle);
+  for (i = 0; i < 64; i++)
+    if (zeros[2 * PAGE_SIZE + i] != 0)
+      fail ("zero frame was written by read()");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(zero-page) begin
+(zero-page) read 4096 zero pages
+(zero-page) wrote every 256th page
+(zero-page) open "sample.txt"
+(zero-page) read "sample.txt" into a zero page
+(zero-page) end
+EOF
+pass;
@@ -34,6 +34,7 @@
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
+#include "filesys/buffer_cache.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
@@ -216,16 +217,32 @@ parse_options (char **argv) {
 #ifdef FILESYS
 		else if (!strcmp (name, "-f"))
 			format_filesys = true;
+		else if (!strcmp (name, "-no-dma"))
+			disk_dma = false;
 #endif
 		else if (!strcmp (name, "-rs"))
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-fault-around"))
+			vm_fault_around = atoi (value);
+		else if (!strcmp (name, "-stack-limit"))
+			vm_stack_limit = (size_t) atoi (value) * 1024;
+		else if (!strcmp (name, "-ksm"))
+			vm_ksm = true;
+		else if (!strcmp (name, "-ksm-budget"))
+			vm_ksm_budget = atoi (value);
+		else if (!strcmp (name, "-spt"))
+			vm_spt_hash = value != NULL && !strcmp (value, "hash");
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -326,8 +343,19 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -tickless          Stop the timer tick while the CPU is idle.\n"
+#ifdef FILESYS
+			"  -no-dma            Transfer disk sectors by PIO, without bus-master DMA.\n"
+#endif
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -fault-around=N    Map up to N following pages on a read fault.\n"
+			"  -stack-limit=KB    Let user stacks grow to KB kB (default 1024).\n"
+			"  -spt=hash|radix    Supplemental page table layout (default radix).\n"
+			"  -ksm               Merge identical anonymous frames in the background.\n"
+			"  -ksm-budget=MS     Let -ksm use up to MS ms of CPU per second (default 20).\n"
 #endif
 			);
 	power_off ();
@@ -356,10 +384,15 @@ print_stats (void) {
 	thread_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
+	buffer_cache_print_stats ();
 #endif
 	console_print_stats ();
 	kbd_print_stats ();
 #ifdef USERPROG
 	exception_print_stats ();
+	process_print_stats ();
+#endif
+#ifdef VM
+	vm_print_stats ();
 #endif
 }
@@ -158,27 +158,42 @@ sema_test_helper (void *sema_) {
 }
 
 
+/* Number of times lock_acquire() yields to a runnable holder,
+   retrying after each yield, before it blocks. */
+#define LOCK_SPIN_CNT 8
+
+static bool lock_holder_runnable (const struct lock *);
+
+/* Sequence number handed to each thread that starts waiting on
+   a lock, so that waiters of equal priority are served in FIFO
+   order. */
+static uint64_t lock_wait_seq;
+
 /* Initializes LOCK.  A lock can be held by at most a single
    thread at any given time.  Our locks are not "recursive", that
    is, it is an error for the thread currently holding a lock to
    try to acquire that lock.
 
-   A lock is a specialization of a semaphore with an initial
-   value of 1.  The difference between a lock and such a
-   semaphore is twofold.  First, a semaphore can have a value
-   greater than 1, but a lock can only be owned by a single
-   thread at a time.  Second, a semaphore does not have an owner,
-   meaning that one thread can "down" the semaphore and then
-   another one "up" it, but with a lock the same thread must both
-   acquire and release it.  When these restrictions prove
-   onerous, it's a good sign that a semaphore should be used,
-   instead of a lock. */
+   A lock is similar to a semaphore with an initial value of 1.
+   The difference between a lock and such a semaphore is
+   twofold.  First, a semaphore can have a value greater than 1,
+   but a lock can only be owned by a single thread at a time.
+   Second, a semaphore does not have an owner, meaning that one
+   thread can "down" the semaphore and then another one "up" it,
+   but with a lock the same thread must both acquire and release
+   it.  When these restrictions prove onerous, it's a good sign
+   that a semaphore should be used, instead of a lock.
+
+   Because a lock has an owner, it can donate the priority of
+   its highest-priority waiter to that owner.  The waiters are
+   kept in a heap so that donation and release take O(log n)
+   time in the number of waiters. */
 void
 lock_init (struct lock *lock) {
 	ASSERT (lock != NULL);
 
 	lock->holder = NULL;
-	sema_init (&lock->semaphore, 1);
+	heap_init (&lock->waiters, cmp_lock_waiter, NULL);
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -191,22 +206,42 @@ lock_init (struct lock *lock) {
    we need to sleep. */
 void
 lock_acquire (struct lock *lock) {
-	struct  thread *curr = thread_current();
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 
-	/* lock holder check */
-	if (lock->holder) {
-		curr->wait_on_lock = lock;
-		list_insert_ordered(&lock->holder->donations, &curr->donation_elem, cmp_donations, NULL);
-		donate_priority();
+	/* Most critical sections are shorter than a trip through the
+	   donation and blocking path.  While the holder is ready to
+	   run, let it finish and retry instead of blocking. */
+	if (lock_try_acquire (lock))
+		return;
+	for (int spin = 0; spin < LOCK_SPIN_CNT && lock_holder_runnable (lock); spin++) {
+		thread_yield ();
+		if (lock_try_acquire (lock))
+			return;
 	}
 
-	sema_down (&lock->semaphore);
-	curr->wait_on_lock = NULL;
-	lock->holder = thread_current ();
+	old_level = intr_disable ();
+	if (lock->holder != NULL) {
+		/* Wait in the lock's heap and donate our priority down
+		   the chain of holders.  lock_release() hands the lock
+		   directly to the highest-priority waiter. */
+		curr->wait_on_lock = lock;
+		curr->lock_wait_seq = lock_wait_seq++;
+		heap_push (&lock->waiters, &curr->lock_elem);
+		heap_update (&lock->holder->held_locks, &lock->elem);
+		donate_priority (curr);
+
+		thread_block ();
+		ASSERT (lock->holder == curr);
+	} else {
+		lock->holder = curr;
+		heap_push (&curr->held_locks, &lock->elem);
+	}
+	intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -217,33 +252,57 @@ lock_acquire (struct lock *lock) {
    interrupt handler. */
 bool
 lock_try_acquire (struct lock *lock) {
+	enum intr_level old_level;
 	bool success;
 
 	ASSERT (lock != NULL);
 	ASSERT (!lock_held_by_current_thread (lock));
 
-	success = sema_try_down (&lock->semaphore);
-	if (success)
+	old_level = intr_disable ();
+	success = lock->holder == NULL;
+	if (success) {
 		lock->holder = thread_current ();
+		heap_push (&lock->holder->held_locks, &lock->elem);
+	}
+	intr_set_level (old_level);
 	return success;
 }
 
 /* Releases LOCK, which must be owned by the current thread.
    This is lock_release function.
 
+   If any threads are waiting, ownership passes directly to the
+   one with the highest priority, which inherits the donations of
+   the remaining waiters.
+
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to release a lock within an interrupt
    handler. */
 void
 lock_release (struct lock *lock) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
-	remove_with_lock(lock);
-	refresh_priority();
-
-	lock->holder = NULL;
-	sema_up (&lock->semaphore);
+	old_level = intr_disable ();
+	heap_remove (&curr->held_locks, &lock->elem);
+	if (heap_empty (&lock->waiters))
+		lock->holder = NULL;
+	else {
+		struct thread *next = heap_entry (heap_pop (&lock->waiters),
+				struct thread, lock_elem);
+
+		next->wait_on_lock = NULL;
+		lock->holder = next;
+		heap_push (&next->held_locks, &lock->elem);
+		refresh_priority (next);
+		thread_unblock (next);
+	}
+	refresh_priority (curr);
+	schedule_preemption ();
+	intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -255,7 +314,144 @@ lock_held_by_current_thread (const struct lock *lock) {
 
 	return lock->holder == thread_current ();
 }
-
+
+/* Returns true if LOCK's holder is ready to run and would get
+   the CPU if the current thread yielded, that is, its priority is
+   at least ours.  Yielding to a lower-priority holder would not
+   let it run; it needs our donation instead. */
+static bool
+lock_holder_runnable (const struct lock *lock) {
+	enum intr_level old_level = intr_disable ();
+	struct thread *holder = lock->holder;
+	bool runnable = holder != NULL && holder->status == THREAD_READY
+		&& holder->priority >= thread_get_priority ();
+	intr_set_level (old_level);
+	return runnable;
+}
+
+/* Returns the priority LOCK donates to its holder, that is, the
+   priority of its highest-priority waiter, or PRI_MIN - 1 if no
+   thread is waiting. */
+int
+lock_donated_priority (const struct lock *lock) {
+	struct heap_elem *top = heap_top (&lock->waiters);
+
+	if (top == NULL)
+		return PRI_MIN - 1;
+	return heap_entry (top, struct thread, lock_elem)->priority;
+}
+
+/* Orders a lock's waiters: higher priority first, then first
+   come, first served. */
+bool
+cmp_lock_waiter (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, lock_elem);
+	const struct thread *b = heap_entry (b_, struct thread, lock_elem);
+
+	if (a->priority != b->priority)
+		return a->priority > b->priority;
+	return a->lock_wait_seq < b->lock_wait_seq;
+}
+
+/* Orders the locks a thread holds by the priority they donate,
+   highest first. */
+bool
+cmp_held_lock (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return lock_donated_priority (heap_entry (a, struct lock, elem))
+		> lock_donated_priority (heap_entry (b, struct lock, elem));
+}
+
+/* Initializes readers-writer lock RW.  Any number of readers
+   may hold RW at once, or a single writer.
+
+   The active writer holds RW's internal lock for as long as it
+   writes, and every reader passes through that lock on the way
+   in.  Hence a writer that has arrived keeps out every reader
+   that arrives after it (writer preference), and threads that
+   wait for a writer donate their priority to it like they would
+   to the holder of a plain lock.  Active readers are not tracked
+   individually, so they do not receive donations. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->writer);
+	rw->readers = 0;
+	rw->draining = false;
+	sema_init (&rw->drained, 0);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   is waiting for the current readers to leave. */
+void
+rwlock_read_acquire (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	lock_acquire (&rw->writer);
+	old_level = intr_disable ();
+	rw->readers++;
+	intr_set_level (old_level);
+	lock_release (&rw->writer);
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void
+rwlock_read_release (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (rw->readers > 0);
+	if (--rw->readers == 0 && rw->draining) {
+		rw->draining = false;
+		sema_up (&rw->drained);
+	}
+	intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it. */
+void
+rwlock_write_acquire (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	/* Holding the internal lock keeps new readers out; then wait
+	   for the current ones to leave. */
+	lock_acquire (&rw->writer);
+	old_level = intr_disable ();
+	if (rw->readers > 0) {
+		rw->draining = true;
+		sema_down (&rw->drained);
+	}
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void
+rwlock_write_release (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+	ASSERT (rw->readers == 0);
+
+	lock_release (&rw->writer);
+}
+
+/* Returns true if the current thread holds RW for writing. */
+bool
+rwlock_held_for_write (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return lock_held_by_current_thread (&rw->writer);
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem {
 	struct list_elem elem;              /* List element. */
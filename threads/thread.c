@@ -4,12 +4,14 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/fixed-point.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -24,10 +26,34 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-static struct list sleep_list; // sleep list 생성 (sleep queue)
+/* Run queue of processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running.
+   There is one FIFO list per priority level, and bit P of
+   ready_bitmap is set iff ready_queues[P] is nonempty, so the
+   highest-priority ready thread is found in O(1). */
+#if PRI_MAX >= 64
+#error ready_bitmap requires PRI_MAX < 64
+#endif
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_bitmap;
+
+/* Threads blocked in thread_sleep(), as a min-heap on
+   wake_up_tick, so that timer_interrupt only ever touches the
+   threads that are actually due. */
+static struct heap sleep_heap;
+
+/* List of all processes.  Processes are added to this list
+   when they are first scheduled and removed when they exit. */
+static struct list all_list;
+
+/* Number of threads in the run queue. */
+static int ready_cnt;
+
+/* Number of times a thread was put to sleep, and the total time,
+   in CPU cycles, that the sleep queue kept interrupts disabled
+   putting threads to sleep and waking them up. */
+static uint64_t sleep_cnt;
+static uint64_t sleep_intr_off_cycles;
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -49,13 +75,20 @@ static long long user_ticks;   /* # of timer ticks in user programs. */
 /* Scheduling. */
 #define TIME_SLICE 4					   /* # of timer ticks to give each thread. */
 static unsigned thread_ticks;			   /* # of timer ticks since last yield. */
-static int64_t min_awake_tick = INT16_MAX; /* # 가장 짧은 wake tick 저장 */
+static int64_t min_awake_tick = INT64_MAX; /* # 가장 짧은 wake tick 저장 */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* MLFQS state. */
+static fixed_t load_avg;			   /* System load average. */
+static struct list mlfqs_dirty_list;   /* Threads charged a tick since the
+										  last priority recalculation. */
+static uint64_t mlfqs_update_cycles;   /* Cost of the last once-per-second
+										  update, in CPU cycles. */
+
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
@@ -64,6 +97,13 @@ static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
+static void ready_queue_push(struct thread *);
+static void ready_queue_remove(struct thread *);
+static int ready_queue_max_priority(void);
+static void record_intr_off_cycles(uint64_t cycles);
+static void mlfqs_tick(int64_t ticks);
+static void mlfqs_update_second(void);
+static void mlfqs_update_priority(struct thread *);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -107,8 +147,12 @@ void thread_init(void)
 
 	/* Init the globla thread context */
 	lock_init(&tid_lock);
-	list_init(&ready_list);
-	list_init(&sleep_list);
+	for (int i = PRI_MIN; i <= PRI_MAX; i++)
+		list_init(&ready_queues[i]);
+	ready_bitmap = 0;
+	heap_init(&sleep_heap, cmp_wake_up_tick, NULL);
+	list_init(&all_list);
+	list_init(&mlfqs_dirty_list);
 	list_init(&destruction_req);
 
 	/* Set up a thread structure for the running thread. */
@@ -150,11 +194,37 @@ void thread_tick(void)
 	else
 		kernel_ticks++;
 
+	if (thread_mlfqs)
+	{
+		mlfqs_tick(timer_ticks());
+
+		/* Recalculation may have lowered our priority below that
+		   of a ready thread. */
+		if (ready_bitmap != 0 && ready_queue_max_priority() > t->priority)
+			intr_yield_on_return();
+	}
+
 	/* Enforce preemption. */
 	if (++thread_ticks >= TIME_SLICE)
 		intr_yield_on_return();
 }
 
+/* Accounts CNT timer ticks that elapsed while the idle thread
+   was halted without receiving timer interrupts (see
+   timer_idle_exit()). */
+void thread_idle_catchup(int64_t cnt)
+{
+	int64_t now = timer_ticks();
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	idle_ticks += cnt;
+
+	/* Do not miss the once-per-second MLFQS update. */
+	if (thread_mlfqs && now / TIMER_FREQ != (now - cnt) / TIMER_FREQ)
+		mlfqs_update_second();
+}
+
 /* Prints thread statistics. */
 void thread_print_stats(void)
 {
@@ -194,6 +264,15 @@ tid_t thread_create(const char *name, int priority,
 	init_thread(t, name, priority);
 	tid = t->tid = allocate_tid();
 
+	/* Under the MLFQS, the new thread inherits its parent's nice
+	   value and recent_cpu, and PRIORITY is ignored. */
+	if (thread_mlfqs)
+	{
+		t->nice = thread_current()->nice;
+		t->recent_cpu = thread_current()->recent_cpu;
+		mlfqs_update_priority(t);
+	}
+
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
 	t->tf.rip = (uintptr_t)kernel_thread;
@@ -251,9 +330,8 @@ void thread_unblock(struct thread *t)
 
 	old_level = intr_disable();
 	ASSERT(t->status == THREAD_BLOCKED);
-	// list_push_back (&ready_list, &t->elem);
-	list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL);
 	t->status = THREAD_READY;
+	ready_queue_push(t);
 	intr_set_level(old_level);
 }
 
@@ -302,6 +380,9 @@ void thread_exit(void)
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable();
+	list_remove(&thread_current()->all_elem);
+	if (thread_current()->mlfqs_dirty)
+		list_remove(&thread_current()->dirty_elem);
 	do_schedule(THREAD_DYING);
 	NOT_REACHED();
 }
@@ -317,8 +398,7 @@ void thread_yield(void)
 
 	old_level = intr_disable();
 	if (curr != idle_thread)
-		list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
-	// list_push_back (&ready_list, &curr->elem);
+		ready_queue_push(curr);
 	do_schedule(THREAD_READY);
 	intr_set_level(old_level);
 }
@@ -328,43 +408,47 @@ void thread_sleep(int64_t until_ticks)
 {
 	struct thread *curr = thread_current();
 	enum intr_level old_level;
+	uint64_t start;
 
 	old_level = intr_disable();
 	if (curr != idle_thread)
-	{																		   // idle의 sleep 요청은 무시
-		curr->wake_up_tick = until_ticks;									   // 깨어나야 하는 시간 설정
-		list_insert_ordered(&sleep_list, &curr->elem, cmp_wake_up_tick, NULL); // sleep_list에 wake_up_tick 작은 순서대로 넣기
+	{										   // idle의 sleep 요청은 무시
+		start = rdtsc();
+		curr->wake_up_tick = until_ticks;		   // 깨어나야 하는 시간 설정
+		heap_push(&sleep_heap, &curr->sleep_elem); // wake_up_tick이 가장 작은 스레드가 top
 		update_min_awake_tick();
+		sleep_cnt++;
+		record_intr_off_cycles(rdtsc() - start);
 		thread_block();
 	}
 	intr_set_level(old_level);
 }
 
+/* Wakes up every sleeping thread whose wake_up_tick is at or
+   before TICKS.  Called from the timer interrupt handler. */
 void thread_awake(int64_t ticks)
 {
-	struct list_elem *cur_elem;
-	int64_t new_min_awake_tick = INT64_MAX;
+	uint64_t start = rdtsc();
 
-	cur_elem = list_begin(&sleep_list);
-	while (cur_elem != list_end(&sleep_list))
+	while (!heap_empty(&sleep_heap))
 	{
-		struct thread *find_thread = list_entry(cur_elem, struct thread, elem);
-		if (find_thread->wake_up_tick <= ticks)
-		{
-			cur_elem = list_remove(cur_elem); // sleep list에서 빼기
-			thread_unblock(find_thread);
-		}
-		else
+		struct thread *t = heap_entry(heap_top(&sleep_heap), struct thread, sleep_elem);
+		if (t->wake_up_tick > ticks)
 			break;
+		heap_pop(&sleep_heap); // sleep heap에서 빼기
+		thread_unblock(t);
 	}
 	update_min_awake_tick();
+	record_intr_off_cycles(rdtsc() - start);
 }
 
 /* global awake tick 재설정 */
 void update_min_awake_tick(void)
 {
-	struct thread *min_wake_up_thread = list_entry(list_begin(&sleep_list), struct thread, elem);
-	min_awake_tick = min_wake_up_thread->wake_up_tick;
+	if (heap_empty(&sleep_heap))
+		min_awake_tick = INT64_MAX;
+	else
+		min_awake_tick = heap_entry(heap_top(&sleep_heap), struct thread, sleep_elem)->wake_up_tick;
 }
 
 int64_t get_min_awake_tick(void)
@@ -372,20 +456,42 @@ int64_t get_min_awake_tick(void)
 	return min_awake_tick;
 }
 
-bool cmp_wake_up_tick(const struct list_elem *cmp_elem, const struct list_elem *list_elem, void *aux UNUSED)
+/* Returns the average time, in CPU cycles, that the sleep queue
+   has kept interrupts disabled per thread put to sleep, counting
+   both the insertion and the wakeup, and starts measuring again
+   from zero. */
+uint64_t thread_sleep_reset_cycles(void)
 {
-	struct thread *cmp_thread = list_entry(cmp_elem, struct thread, elem);
-	struct thread *list_thread = list_entry(list_elem, struct thread, elem);
-	if (cmp_thread->wake_up_tick > list_thread->wake_up_tick)
-		return false;
-	return true;
+	enum intr_level old_level = intr_disable();
+	uint64_t avg = sleep_cnt != 0 ? sleep_intr_off_cycles / sleep_cnt : 0;
+	sleep_cnt = 0;
+	sleep_intr_off_cycles = 0;
+	intr_set_level(old_level);
+	return avg;
+}
+
+static void
+record_intr_off_cycles(uint64_t cycles)
+{
+	sleep_intr_off_cycles += cycles;
+}
+
+bool cmp_wake_up_tick(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED)
+{
+	struct thread *a_thread = heap_entry(a, struct thread, sleep_elem);
+	struct thread *b_thread = heap_entry(b, struct thread, sleep_elem);
+	return a_thread->wake_up_tick < b_thread->wake_up_tick;
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void thread_set_priority(int new_priority)
 {
+	/* The MLFQS computes priorities itself. */
+	if (thread_mlfqs)
+		return;
+
 	thread_current()->init_priority = new_priority;
-	refresh_priority();
+	refresh_priority(thread_current());
 	schedule_preemption();
 }
 
@@ -406,111 +512,222 @@ bool cmp_priority(const struct list_elem *cmp_elem, const struct list_elem *list
 	return false;
 }
 
+/* Yields the CPU if a ready thread has a higher priority than
+   the running thread. */
 void schedule_preemption(void)
 {
-	// struct thread *curr = running_thread();
-	struct thread *curr = thread_current();
-	struct list_elem *max_priority = list_begin(&ready_list);
-
-	if (list_empty(&ready_list))
+	if (intr_context() || ready_bitmap == 0)
 		return;
 
-	if (!intr_context() && !cmp_priority(&curr->elem, &max_priority, NULL))
+	if (thread_current()->priority < ready_queue_max_priority())
 		thread_yield();
 }
 
-/* donations compare */
-bool cmp_donations(const struct list_elem *cmp_elem, const struct list_elem *list_elem, void *aux)
+/* Changes T's effective priority to PRIORITY.  A ready thread is
+   moved to the run queue of its new priority, at the back; a
+   thread waiting on a lock is repositioned in the lock's waiters
+   and the lock in its holder's held locks. */
+void thread_set_effective_priority(struct thread *t, int priority)
 {
-	struct thread *cmp_thread = list_entry(cmp_elem, struct thread, donation_elem);
-	struct thread *list_thread = list_entry(list_elem, struct thread, donation_elem);
-
-	if (cmp_thread->priority > list_thread->priority)
-		return true;
-	return false;
-}
+	enum intr_level old_level;
 
-void donate_priority(void)
-{
-	// struct thread *curr = running_thread();
-	struct thread *curr = thread_current();
-	struct thread *next = curr->wait_on_lock->holder;
-	int cnt = 0;
+	ASSERT(is_thread(t));
+	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
 
-	while (next)
+	old_level = intr_disable();
+	if (t->priority != priority)
 	{
-		// nested 8단계 확인
-		if (cnt == 8)
-			break;
-
-		next->priority = curr->priority;
-
-		if (next->wait_on_lock)
+		if (t->status == THREAD_READY)
 		{
-			next = next->wait_on_lock->holder;
-			cnt += 1;
+			ready_queue_remove(t);
+			t->priority = priority;
+			ready_queue_push(t);
 		}
 		else
-			break;
+			t->priority = priority;
+
+		if (t->wait_on_lock != NULL)
+		{
+			struct lock *lock = t->wait_on_lock;
+
+			heap_update(&lock->waiters, &t->lock_elem);
+			heap_update(&lock->holder->held_locks, &lock->elem);
+		}
 	}
+	intr_set_level(old_level);
 }
 
-/* 락 놔줄 때 락 기다리고 있던 donations 지우기 */
-void remove_with_lock(struct lock *lock)
+/* Propagates the priority of T, which has just started waiting
+   on a lock or had its priority raised while waiting, down the
+   chain of lock holders.  Each step costs O(log n) in the number
+   of waiters and held locks.  The walk stops as soon as a holder's
+   priority does not change, so it also terminates on a cycle of
+   waiting threads.  Interrupts must be off. */
+void donate_priority(struct thread *t)
 {
-	// struct thread *curr = running_thread();
-	struct thread *curr = thread_current();
-	struct list_elem *donation = list_begin(&curr->donations);
+	ASSERT(intr_get_level() == INTR_OFF);
 
-	while (donation)
+	while (t->wait_on_lock != NULL)
 	{
-		if (list_entry(donation, struct thread, donation_elem)->wait_on_lock == lock)
-			list_remove(donation);
-		donation = donation->next;
+		struct thread *holder = t->wait_on_lock->holder;
+		int old_priority = holder->priority;
+
+		refresh_priority(holder);
+		if (holder->priority == old_priority)
+			break;
+		t = holder;
 	}
 }
 
-void refresh_priority(void)
+/* Recomputes T's effective priority as the larger of its own
+   priority and the priority donated by the locks it holds. */
+void refresh_priority(struct thread *t)
 {
-	// struct thread *curr = running_thread();
-	struct thread *curr = thread_current();
-	curr->priority = curr->init_priority;
+	int priority = t->init_priority;
+	struct heap_elem *top;
 
-	if (list_empty(&curr->donations))
+	if (thread_mlfqs)
 		return;
 
-	list_sort(&curr->donations, cmp_donations, NULL);
-
-	int max_priority = list_entry(list_begin(&curr->donations), struct thread, donation_elem)->priority;
-	if (curr->priority < max_priority)
-		curr->priority = max_priority;
+	top = heap_top(&t->held_locks);
+	if (top != NULL)
+	{
+		int donated = lock_donated_priority(heap_entry(top, struct lock, elem));
+		if (donated > priority)
+			priority = donated;
+	}
+	thread_set_effective_priority(t, priority);
 }
 
-/* Sets the current thread's nice value to NICE. */
-void thread_set_nice(int nice UNUSED)
+/* Sets the current thread's nice value to NICE and recalculates
+   its priority.  Yields if it no longer has the highest
+   priority. */
+void thread_set_nice(int nice)
 {
-	/* TODO: Your implementation goes here */
+	enum intr_level old_level;
+
+	ASSERT(NICE_MIN <= nice && nice <= NICE_MAX);
+
+	old_level = intr_disable();
+	thread_current()->nice = nice;
+	mlfqs_update_priority(thread_current());
+	intr_set_level(old_level);
+
+	schedule_preemption();
 }
 
 /* Returns the current thread's nice value. */
 int thread_get_nice(void)
 {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int thread_get_load_avg(void)
 {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable();
+	int load_avg_100 = fp_to_int_round(mult_mixed(load_avg, 100));
+	intr_set_level(old_level);
+	return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int thread_get_recent_cpu(void)
 {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable();
+	int recent_cpu_100 = fp_to_int_round(mult_mixed(thread_current()->recent_cpu, 100));
+	intr_set_level(old_level);
+	return recent_cpu_100;
+}
+
+/* Returns how long, in CPU cycles, the last once-per-second
+   update of load_avg and every thread's recent_cpu took. */
+uint64_t thread_mlfqs_update_cycles(void)
+{
+	return mlfqs_update_cycles;
+}
+
+/* Does the MLFQS bookkeeping for timer tick TICKS: charges the
+   tick to the running thread, updates load_avg and recent_cpu
+   once per second, and recalculates priorities every fourth
+   tick.  A priority only depends on recent_cpu and nice, so
+   every fourth tick we only visit the threads that were charged
+   a tick since the last time; the per-second update recalculates
+   the threads whose recent_cpu it changes. */
+static void
+mlfqs_tick(int64_t ticks)
+{
+	struct thread *t = thread_current();
+
+	if (t != idle_thread)
+	{
+		t->recent_cpu = add_mixed(t->recent_cpu, 1);
+		if (!t->mlfqs_dirty)
+		{
+			t->mlfqs_dirty = true;
+			list_push_back(&mlfqs_dirty_list, &t->dirty_elem);
+		}
+	}
+
+	if (ticks % TIMER_FREQ == 0)
+		mlfqs_update_second();
+
+	if (ticks % TIME_SLICE == 0)
+		while (!list_empty(&mlfqs_dirty_list))
+		{
+			t = list_entry(list_pop_front(&mlfqs_dirty_list), struct thread, dirty_elem);
+			t->mlfqs_dirty = false;
+			mlfqs_update_priority(t);
+		}
+}
+
+/* Updates load_avg, then decays every thread's recent_cpu. */
+static void
+mlfqs_update_second(void)
+{
+	uint64_t start = rdtsc();
+	int ready_threads = ready_cnt + (thread_current() != idle_thread);
+	fixed_t coef;
+	struct list_elem *e;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	/* load_avg = (59/60)*load_avg + (1/60)*ready_threads */
+	load_avg = add_fp(div_mixed(mult_mixed(load_avg, 59), 60),
+					  div_mixed(int_to_fp(ready_threads), 60));
+
+	/* recent_cpu = (2*load_avg)/(2*load_avg + 1)*recent_cpu + nice */
+	coef = div_fp(mult_mixed(load_avg, 2), add_mixed(mult_mixed(load_avg, 2), 1));
+	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e))
+	{
+		struct thread *t = list_entry(e, struct thread, all_elem);
+		fixed_t recent_cpu;
+
+		if (t == idle_thread)
+			continue;
+		recent_cpu = add_mixed(mult_fp(coef, t->recent_cpu), t->nice);
+		if (recent_cpu != t->recent_cpu)
+		{
+			t->recent_cpu = recent_cpu;
+			mlfqs_update_priority(t);
+		}
+	}
+
+	mlfqs_update_cycles = rdtsc() - start;
+}
+
+/* Sets T's priority to PRI_MAX - (recent_cpu / 4) - (nice * 2),
+   clamped to the valid range. */
+static void
+mlfqs_update_priority(struct thread *t)
+{
+	int priority = PRI_MAX - fp_to_int(div_mixed(t->recent_cpu, 4)) - t->nice * 2;
+
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	else if (priority > PRI_MAX)
+		priority = PRI_MAX;
+	thread_set_effective_priority(t, priority);
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -534,8 +751,13 @@ idle(void *idle_started_ UNUSED)
 	{
 		/* Let someone else run. */
 		intr_disable();
+		timer_idle_exit();
 		thread_block();
 
+		/* In tickless mode, skip timer ticks until the next
+		   sleeper is due. */
+		timer_idle_enter();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -568,6 +790,8 @@ kernel_thread(thread_func *function, void *aux)
 static void
 init_thread(struct thread *t, const char *name, int priority)
 {
+	enum intr_level old_level;
+
 	ASSERT(t != NULL);
 	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
 	ASSERT(name != NULL);
@@ -579,7 +803,7 @@ init_thread(struct thread *t, const char *name, int priority)
 	t->priority = priority;
 	t->init_priority = priority;
 	t->wait_on_lock = NULL;
-	list_init(&t->donations);
+	heap_init(&t->held_locks, cmp_held_lock, NULL);
 	list_init(&t->child_list);
 
 	sema_init(&t->load_sema, 0);
@@ -595,6 +819,10 @@ init_thread(struct thread *t, const char *name, int priority)
 	t->exit_status = 0;
 
 	t->magic = THREAD_MAGIC;
+
+	old_level = intr_disable();
+	list_push_back(&all_list, &t->all_elem);
+	intr_set_level(old_level);
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -605,10 +833,48 @@ init_thread(struct thread *t, const char *name, int priority)
 static struct thread *
 next_thread_to_run(void)
 {
-	if (list_empty(&ready_list))
+	struct thread *next;
+
+	if (ready_bitmap == 0)
 		return idle_thread;
-	else
-		return list_entry(list_pop_front(&ready_list), struct thread, elem);
+
+	next = list_entry(list_front(&ready_queues[ready_queue_max_priority()]),
+					  struct thread, elem);
+	ready_queue_remove(next);
+	return next;
+}
+
+/* Appends T to the back of the run queue for its priority. */
+static void
+ready_queue_push(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	list_push_back(&ready_queues[t->priority], &t->elem);
+	ready_bitmap |= 1ULL << t->priority;
+	ready_cnt++;
+}
+
+/* Removes T from the run queue for its priority. */
+static void
+ready_queue_remove(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	list_remove(&t->elem);
+	if (list_empty(&ready_queues[t->priority]))
+		ready_bitmap &= ~(1ULL << t->priority);
+	ready_cnt--;
+}
+
+/* Returns the highest priority that has a ready thread.
+   The run queue must not be empty. */
+static int
+ready_queue_max_priority(void)
+{
+	ASSERT(ready_bitmap != 0);
+
+	return 63 - __builtin_clzll(ready_bitmap);
 }
 
 /* Use iretq to launch the thread */
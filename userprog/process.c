@@ -13,6 +13,7 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -29,6 +30,26 @@ static void __do_fork (void *);
 
 struct lock load_lock;
 
+/* Fork statistics: number of successful forks and the TSC cycles
+ * the parent spent in them, from thread_create() until the child
+ * finished duplicating its address space. */
+static uint64_t fork_cnt;
+static uint64_t fork_cycles;
+
+/* Exec statistics: number of successful loads and the TSC cycles
+ * spent in load(). */
+static uint64_t exec_cnt;
+static uint64_t exec_cycles;
+
+/* Prints fork statistics. */
+void
+process_print_stats (void) {
+	printf ("Fork: %llu forks, %llu cycles avg\n", fork_cnt,
+			fork_cnt != 0 ? fork_cycles / fork_cnt : 0);
+	printf ("Exec: %llu loads, %llu cycles avg\n", exec_cnt,
+			exec_cnt != 0 ? exec_cycles / exec_cnt : 0);
+}
+
 /* General process initializer for initd and other process. */
 static void
 process_init (void) {
@@ -94,6 +115,7 @@ tid_t
 process_fork (const char *name, struct intr_frame *if_) {
 	/* Clone current thread to new thread.*/
 	struct thread *cur = thread_current();
+	uint64_t start = rdtsc ();
 
 	int tid = thread_create (name,
 			PRI_DEFAULT, __do_fork, cur);
@@ -106,6 +128,8 @@ process_fork (const char *name, struct intr_frame *if_) {
 	if (child->exit_status == TID_ERROR) {
 		return TID_ERROR;
 	}
+	fork_cycles += rdtsc () - start;
+	fork_cnt++;
 	return tid;
 }
 
@@ -174,6 +198,13 @@ __do_fork (void *aux) {
 
 	process_activate (current);
 #ifdef VM
+	/* 아직 올라오지 않은 실행 파일 page는 자식의 running_file에서
+	 * 읽으므로 SPT보다 먼저 복사한다. */
+	if (parent->running_file != NULL) {
+		current->running_file = file_duplicate (parent->running_file);
+		if (current->running_file == NULL)
+			goto error;
+	}
 	supplemental_page_table_init (&current->spt);
 	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
 		goto error;
@@ -278,8 +309,13 @@ process_exec (void *f_name) {
 
 	/* We first kill the current context */
 	process_cleanup ();
+	/* 새 실행 파일을 열기 전에 이전 것을 닫는다.  fork한 자식도 부모의
+	 * 실행 파일을 복제해서 갖고 있다. */
+	file_close (thread_current ()->running_file);
+	thread_current ()->running_file = NULL;
 
 	/* And then load the binary */
+	uint64_t start = rdtsc ();
 	success = load (file_name, &_if);
 
 	/* If load failed, quit. */
@@ -287,6 +323,8 @@ process_exec (void *f_name) {
 		palloc_free_page (file_name);
 		return -1;
 	}
+	exec_cycles += rdtsc () - start;
+	exec_cnt++;
 
 	argument_stack(parse, count, &_if);
 
@@ -914,6 +952,17 @@ lazy_load_segment (struct page *page, void *aux) {
 	/* TODO: Load the segment from the file */
 	/* TODO: This called when the first page fault occurs on address VA. */
 	/* TODO: VA is available when calling this function. */
+	/* AUX says where the page comes from; its file is the process's
+	 * running_file, kept open until exit. */
+	struct file_page *la = aux;
+	uint8_t *kva = page->frame->kva;
+	bool success;
+
+	success = file_read_at (la->file, kva, la->read_bytes, la->ofs)
+		== (off_t) la->read_bytes;
+	memset (kva + la->read_bytes, 0, PGSIZE - la->read_bytes);
+	free (la);
+	return success;
 }
 
 /* Loads a segment starting at offset OFS in FILE at address
@@ -945,15 +994,30 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		void *aux = NULL;
-		if (!vm_alloc_page_with_initializer (VM_ANON, upage,
-					writable, lazy_load_segment, aux))
+		/* 전부 0인 page(bss)는 읽을 것이 없으므로 그냥 anon page로 둔다. */
+		struct file_page *aux = NULL;
+		vm_initializer *init = NULL;
+		if (page_read_bytes > 0) {
+			aux = malloc (sizeof *aux);
+			if (aux == NULL)
+				return false;
+			aux->file = file;
+			aux->ofs = ofs;
+			aux->read_bytes = page_read_bytes;
+			init = lazy_load_segment;
+		}
+		if (!vm_alloc_page_with_initializer (
+					VM_ANON | (aux != NULL ? VM_FILE_INIT : 0), upage,
+					writable, init, aux)) {
+			free (aux);
 			return false;
+		}
 
 		/* Advance. */
 		read_bytes -= page_read_bytes;
 		zero_bytes -= page_zero_bytes;
 		upage += PGSIZE;
+		ofs += page_read_bytes;
 	}
 	return true;
 }
@@ -968,6 +1032,11 @@ setup_stack (struct intr_frame *if_) {
 	 * TODO: If success, set the rsp accordingly.
 	 * TODO: You should mark the page is stack. */
 	/* TODO: Your code goes here */
+	if (vm_alloc_page (VM_ANON | VM_STACK, stack_bottom, true)
+			&& vm_claim_page (stack_bottom)) {
+		if_->rsp = USER_STACK;
+		success = true;
+	}
 
 	return success;
 }
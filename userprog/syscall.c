@@ -14,6 +14,9 @@
 #include "include/userprog/process.h"
 #include "threads/palloc.h"
 #include <stdlib.h>
+#ifdef VM
+#include "vm/vm.h"
+#endif
 
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
@@ -31,12 +34,8 @@ void syscall_handler(struct intr_frame *);
 #define MSR_LSTAR 0xc0000082		/* Long mode SYSCALL target */
 #define MSR_SYSCALL_MASK 0xc0000084 /* Mask for the eflags */
 
-struct lock filesys_lock;
-
 void syscall_init(void)
 {
-	lock_init(&filesys_lock);
-
 	write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48 |
 							((uint64_t)SEL_KCSEG) << 32);
 	write_msr(MSR_LSTAR, (uint64_t)syscall_entry);
@@ -50,7 +49,17 @@ void syscall_init(void)
 
 void check_address(void *addr)
 {
-	if (is_kernel_vaddr(addr) || pml4_get_page(thread_current()->pml4, addr) == NULL)
+	struct thread *cur_thread = thread_current();
+
+	if (addr == NULL || is_kernel_vaddr(addr))
+		exit(-1);
+#ifdef VM
+	/* 아직 올라오지 않은 lazy page는 접근할 때 fault로 올라온다. */
+	if (spt_find_page(&cur_thread->spt, addr) != NULL
+		|| vm_is_stack_access(addr, cur_thread->user_tf.rsp))
+		return;
+#endif
+	if (pml4_get_page(cur_thread->pml4, addr) == NULL)
 		exit(-1);
 }
 
@@ -121,6 +130,14 @@ void syscall_handler(struct intr_frame *f)
 	case SYS_WAIT:
 		f->R.rax = wait(f->R.rdi);
 		break;
+#ifdef VM
+	case SYS_MMAP:
+		f->R.rax = (uint64_t)mmap((void *)f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10, f->R.r8);
+		break;
+	case SYS_MUNMAP:
+		munmap((void *)f->R.rdi);
+		break;
+#endif
 	default:
 		thread_exit();
 	}
@@ -161,16 +178,11 @@ int open(const char *file)
 		return -1;
 	}
 
-	lock_acquire(&filesys_lock);
 	struct file *file_obj = filesys_open(file);
 	if (file_obj == NULL)
-	{
-		lock_release(&filesys_lock);
 		return -1;
-	}
 
 	cur_thread->fd_table[cur_thread->max_fd++] = file_obj;
-	lock_release(&filesys_lock);
 	return cur_thread->max_fd - 1;
 }
 
@@ -218,10 +230,16 @@ int read(int fd, void *buffer, unsigned size)
 
 	check_fd(fd, cur_thread);
 	check_address(buffer);
+#ifdef VM
+	/* file system 안에서 buffer에 page fault가 나지 않도록 미리 올려 둔다. */
+	if (!vm_pin_buffer(buffer, size, true))
+		exit(-1);
+#endif
 
-	lock_acquire(&filesys_lock);
 	int read_size = file_read(cur_thread->fd_table[fd], buffer, size);
-	lock_release(&filesys_lock);
+#ifdef VM
+	vm_unpin_buffer(buffer, size);
+#endif
 
 	return read_size;
 }
@@ -239,10 +257,15 @@ int write(int fd, const void *buffer, unsigned size)
 
 	check_fd(fd, cur_thread);
 	check_address(buffer);
+#ifdef VM
+	if (!vm_pin_buffer(buffer, size, false))
+		exit(-1);
+#endif
 
-	lock_acquire(&filesys_lock);
 	int write_size = file_write(cur_thread->fd_table[fd], buffer, size);
-	lock_release(&filesys_lock);
+#ifdef VM
+	vm_unpin_buffer(buffer, size);
+#endif
 
 	return write_size;
 }
@@ -284,4 +307,38 @@ int exec(const char *cmd_line)
 		exit(-1);
 	}
 	return result;
-}
\ No newline at end of file
+}
+
+#ifdef VM
+/* FD로 연 파일의 OFFSET부터 LENGTH 바이트를 ADDR에 맵핑한다.
+ * 인자가 잘못되었거나 ADDR부터의 범위가 이미 쓰이고 있으면
+ * 맵핑하지 않고 NULL(MAP_FAILED)을 반환한다. */
+void *mmap(void *addr, size_t length, int writable, int fd, off_t offset)
+{
+	struct thread *cur_thread = thread_current();
+	struct file *file;
+	uint8_t *upage;
+
+	if (addr == NULL || pg_ofs(addr) != 0 || pg_ofs(offset) != 0 || length == 0)
+		return NULL;
+	if ((uint64_t)addr + length < (uint64_t)addr
+		|| is_kernel_vaddr((uint8_t *)addr + length - 1))
+		return NULL;
+	if (fd < 2 || fd >= MAX_FILE_SIZE || cur_thread->fd_table[fd] == NULL)
+		return NULL;
+	file = cur_thread->fd_table[fd];
+	if (file_length(file) == 0)
+		return NULL;
+
+	for (upage = addr; upage < (uint8_t *)addr + length; upage += PGSIZE)
+		if (spt_find_page(&cur_thread->spt, upage) != NULL)
+			return NULL;
+
+	return do_mmap(addr, length, writable, file, offset);
+}
+
+void munmap(void *addr)
+{
+	do_munmap(addr);
+}
+#endif
\ No newline at end of file
@@ -2,12 +2,20 @@
 
 #include "vm/vm.h"
 #include "devices/disk.h"
+#include <bitmap.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
 static bool anon_swap_in (struct page *page, void *kva);
 static bool anon_swap_out (struct page *page);
 static void anon_destroy (struct page *page);
+static void swap_slot_put (size_t slot);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
@@ -17,36 +25,144 @@ static const struct page_operations anon_ops = {
 	.type = VM_ANON,
 };
 
+/* 한 page를 담는 swap slot의 sector 수. */
+#define SECTORS_PER_SLOT (PGSIZE / DISK_SECTOR_SIZE)
+
+/* Swap slot 사용 여부.  bit i가 켜져 있으면 sector
+ * i * SECTORS_PER_SLOT부터 시작하는 slot이 사용 중이다. */
+static struct bitmap *swap_table;
+/* Slot마다 그 slot을 가리키는 page 수.  fork한 자식은 부모의 swap
+ * out된 page를 읽어 들이지 않고 slot을 같이 가리킨다. */
+static unsigned *swap_refs;
+static struct lock swap_lock;   /* Protects swap_table and swap_refs. */
+
+/* Swap statistics. */
+static uint64_t swap_in_cnt, swap_out_cnt;
+static uint64_t swap_in_cycles, swap_out_cycles;
+
 /* Initialize the data for anonymous pages */
 void
 vm_anon_init (void) {
 	/* TODO: Set up the swap_disk. */
-	swap_disk = NULL;
+	size_t slot_cnt = 0;
+
+	swap_disk = disk_get (1, 1);
+	if (swap_disk != NULL)
+		slot_cnt = disk_size (swap_disk) / SECTORS_PER_SLOT;
+	swap_table = bitmap_create (slot_cnt);
+	swap_refs = calloc (slot_cnt, sizeof *swap_refs);
+	if (swap_table == NULL || (slot_cnt > 0 && swap_refs == NULL))
+		PANIC ("swap table creation failed");
+	lock_init (&swap_lock);
+}
+
+/* Prints swap statistics. */
+void
+vm_anon_print_stats (void) {
+	printf ("Swap: %llu slots, %llu swap-ins (%llu cycles avg), "
+			"%llu swap-outs (%llu cycles avg)\n",
+			(unsigned long long) bitmap_size (swap_table),
+			swap_in_cnt, swap_in_cnt ? swap_in_cycles / swap_in_cnt : 0,
+			swap_out_cnt, swap_out_cnt ? swap_out_cycles / swap_out_cnt : 0);
 }
 
 /* Initialize the file mapping */
 bool
-anon_initializer (struct page *page, enum vm_type type, void *kva) {
+anon_initializer (struct page *page, enum vm_type type UNUSED, void *kva) {
 	/* Set up the handler */
 	page->operations = &anon_ops;
 
 	struct anon_page *anon_page = &page->anon;
+	anon_page->swap_slot = SWAP_SLOT_NONE;
+
+	/* 재사용된 frame에는 다른 page의 내용이 남아 있을 수 있다. */
+	memset (kva, 0, PGSIZE);
+	return true;
 }
 
 /* Swap in the page by read contents from the swap disk. */
 static bool
 anon_swap_in (struct page *page, void *kva) {
 	struct anon_page *anon_page = &page->anon;
+	size_t slot = anon_page->swap_slot;
+	uint64_t start = rdtsc ();
+
+	if (slot == SWAP_SLOT_NONE)
+		return false;
+
+	/* 한 slot 전체를 명령 하나로 읽는다. */
+	disk_read_multi (swap_disk, slot * SECTORS_PER_SLOT, SECTORS_PER_SLOT,
+			kva);
+
+	swap_slot_put (slot);
+	lock_acquire (&swap_lock);
+	swap_in_cnt++;
+	swap_in_cycles += rdtsc () - start;
+	lock_release (&swap_lock);
+
+	anon_page->swap_slot = SWAP_SLOT_NONE;
+	return true;
 }
 
 /* Swap out the page by writing contents to the swap disk. */
 static bool
 anon_swap_out (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+	uint64_t start = rdtsc ();
+	size_t slot;
+
+	lock_acquire (&swap_lock);
+	slot = bitmap_scan_and_flip (swap_table, 0, 1, false);
+	if (slot != BITMAP_ERROR)
+		swap_refs[slot] = 1;
+	lock_release (&swap_lock);
+	if (slot == BITMAP_ERROR)
+		return false;
+
+	disk_write_multi (swap_disk, slot * SECTORS_PER_SLOT, SECTORS_PER_SLOT,
+			page->frame->kva);
+	anon_page->swap_slot = slot;
+
+	lock_acquire (&swap_lock);
+	swap_out_cnt++;
+	swap_out_cycles += rdtsc () - start;
+	lock_release (&swap_lock);
+	return true;
 }
 
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void
 anon_destroy (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+
+	if (anon_page->swap_slot != SWAP_SLOT_NONE) {
+		swap_slot_put (anon_page->swap_slot);
+		anon_page->swap_slot = SWAP_SLOT_NONE;
+	}
+}
+
+/* Makes DST, a copy of the swapped-out anonymous page SRC, refer to
+ * SRC's swap slot too.  The slot is freed once every page referring
+ * to it has been swapped in or destroyed. */
+void
+anon_share_slot (struct page *dst, const struct page *src) {
+	size_t slot = src->anon.swap_slot;
+
+	ASSERT (slot != SWAP_SLOT_NONE);
+
+	lock_acquire (&swap_lock);
+	ASSERT (swap_refs[slot] > 0);
+	swap_refs[slot]++;
+	lock_release (&swap_lock);
+	dst->anon.swap_slot = slot;
+}
+
+/* Drops one reference to SLOT and frees it when none are left. */
+static void
+swap_slot_put (size_t slot) {
+	lock_acquire (&swap_lock);
+	ASSERT (swap_refs[slot] > 0);
+	if (--swap_refs[slot] == 0)
+		bitmap_reset (swap_table, slot);
+	lock_release (&swap_lock);
 }
@@ -1,10 +1,17 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
 #include "vm/vm.h"
+#include <round.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/vaddr.h"
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
 static void file_backed_destroy (struct page *page);
+static bool file_backed_load (struct page *page, void *aux);
+static void file_backed_writeback (struct page *page);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations file_ops = {
@@ -21,38 +28,169 @@ vm_file_init (void) {
 
 /* Initialize the file backed page */
 bool
-file_backed_initializer (struct page *page, enum vm_type type, void *kva) {
+file_backed_initializer (struct page *page, enum vm_type type UNUSED,
+		void *kva UNUSED) {
 	/* Set up the handler */
 	page->operations = &file_ops;
 
 	struct file_page *file_page = &page->file;
+	memset (file_page, 0, sizeof *file_page);
+	return true;
+}
+
+/* Lazy-load callback of a mapped page: takes over AUX, a struct
+   file_page, and reads the page in. */
+static bool
+file_backed_load (struct page *page, void *aux) {
+	page->file = *(struct file_page *) aux;
+	free (aux);
+	return file_backed_swap_in (page, page->frame->kva);
 }
 
 /* Swap in the page by read contents from the file. */
+/* frame을 다른 mapping과 공유하고 있으면 내용이 이미 올라와 있다. */
 static bool
 file_backed_swap_in (struct page *page, void *kva) {
 	struct file_page *file_page UNUSED = &page->file;
+
+	if (page->frame->ref_cnt > 1)
+		return true;
+	if (file_read_at (file_page->file, kva, file_page->read_bytes,
+				file_page->ofs) != (off_t) file_page->read_bytes)
+		return false;
+	memset ((uint8_t *) kva + file_page->read_bytes, 0,
+			PGSIZE - file_page->read_bytes);
+	return true;
 }
 
 /* Swap out the page by writeback contents to the file. */
 static bool
 file_backed_swap_out (struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
+	file_backed_writeback (page);
+	return true;
 }
 
 /* Destory the file backed page. PAGE will be freed by the caller. */
 static void
 file_backed_destroy (struct page *page) {
+	file_backed_writeback (page);
+}
+
+/* Writes PAGE back to its file if it is resident and its owner
+   has modified it.  Clean pages are never written: their contents
+   are already in the file.  Each mapping of a shared frame has its
+   own dirty bit, so whoever wrote to the frame writes it back.
+   With EFILESYS the frame is a page cache frame, which is only
+   marked dirty here and written back by the page cache; a page
+   past the end of the file is never written back. */
+static void
+file_backed_writeback (struct page *page) {
 	struct file_page *file_page UNUSED = &page->file;
+	uint64_t *pml4 = page->owner->pml4;
+
+	if (page->frame == NULL || !pml4_is_dirty (pml4, page->va))
+		return;
+#ifdef EFILESYS
+	if (file_page->read_bytes != 0)
+		page->frame->page->page_cache.dirty = true;
+#else
+	file_write_at (file_page->file, page->frame->kva, file_page->read_bytes,
+			file_page->ofs);
+#endif
+	pml4_set_dirty (pml4, page->va, false);
 }
 
 /* Do the mmap */
+/* FILE의 OFFSET부터 LENGTH 바이트를 ADDR에 lazy하게 맵핑한다.
+ * 파일 끝을 넘는 부분은 0으로 채워지고, 되쓰지 않는다. */
 void *
 do_mmap (void *addr, size_t length, int writable,
 		struct file *file, off_t offset) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct mmap_region *region;
+	off_t file_len;
+	size_t i;
+
+	region = malloc (sizeof *region);
+	if (region == NULL)
+		return NULL;
+	region->addr = addr;
+	region->page_cnt = DIV_ROUND_UP (length, PGSIZE);
+	region->file = file_reopen (file);
+	if (region->file == NULL) {
+		free (region);
+		return NULL;
+	}
+	file_len = file_length (region->file);
+
+	for (i = 0; i < region->page_cnt; i++) {
+		void *upage = (uint8_t *) addr + i * PGSIZE;
+		off_t ofs = offset + i * PGSIZE;
+		struct file_page *aux = malloc (sizeof *aux);
+
+		if (aux == NULL)
+			goto fail;
+		aux->file = region->file;
+		aux->ofs = ofs;
+		aux->read_bytes = ofs < file_len
+			? (file_len - ofs < PGSIZE ? file_len - ofs : PGSIZE) : 0;
+		if (!vm_alloc_page_with_initializer (VM_FILE, upage, writable,
+					file_backed_load, aux)) {
+			free (aux);
+			goto fail;
+		}
+	}
+	list_push_back (&spt->mmaps, &region->elem);
+	return addr;
+
+fail:
+	while (i-- > 0)
+		spt_remove_page (spt,
+				spt_find_page (spt, (uint8_t *) addr + i * PGSIZE));
+	file_close (region->file);
+	free (region);
+	return NULL;
+}
+
+/* Unmaps REGION, writing back its dirty pages, and frees it. */
+static void
+munmap_region (struct mmap_region *region) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	size_t i;
+
+	for (i = 0; i < region->page_cnt; i++) {
+		struct page *page =
+			spt_find_page (spt, (uint8_t *) region->addr + i * PGSIZE);
+		if (page != NULL)
+			spt_remove_page (spt, page);
+	}
+	list_remove (&region->elem);
+	file_close (region->file);
+	free (region);
 }
 
 /* Do the munmap */
 void
 do_munmap (void *addr) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct list_elem *e;
+
+	for (e = list_begin (&spt->mmaps); e != list_end (&spt->mmaps);
+			e = list_next (e)) {
+		struct mmap_region *region = list_entry (e, struct mmap_region, elem);
+		if (region->addr == addr) {
+			munmap_region (region);
+			return;
+		}
+	}
+}
+
+/* Unmaps every region of the current process, as on exit. */
+void
+do_munmap_all (void) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+
+	while (!list_empty (&spt->mmaps))
+		munmap_region (list_entry (list_front (&spt->mmaps),
+					struct mmap_region, elem));
 }
@@ -1,13 +1,126 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
+#include <stdio.h>
+#include <string.h>
 #include "threads/malloc.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
+#include "filesys/inode.h"
 #include <hash.h>
-#include <mmu.h> // for pml4_walk
+#include "threads/mmu.h" // for pml4_walk
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
 
-// Frame_Table을 해쉬 테이블이 아닌 연결 리스트로 선언할 예정이기 때문에 Table -> List
-struct list frame_list;
+/* Frame table.
+ * user pool에서 할당한 모든 frame을 하나의 전역 리스트로 관리한다.
+ * CLOCK_HAND는 second-chance 알고리즘의 시계 바늘로, 리스트를 원형으로
+ * 돌면서 accessed bit가 꺼진 frame을 victim으로 고른다.  새 frame은
+ * 바늘 바로 뒤에 끼워 넣어서 한 바퀴를 다 돈 뒤에야 검사되게 한다.
+ * FRAME_LOCK은 리스트, 바늘, 그리고 frame과 page 사이의 연결을 보호하며,
+ * eviction 하는 동안(swap out 포함) 계속 잡고 있는다. */
+static struct list frame_list;
+static struct list_elem *clock_hand;
+static struct lock frame_lock;
+static size_t frame_cnt;
+
+/* Shared file page table.
+ * 같은 파일의 같은 page를 여러 mapping이 읽으면 frame 하나를 같이 쓴다.
+ * (inode 번호, offset)을 key로 FILE_FRAMES에서 frame을 찾으며 FRAME_LOCK이
+ * 보호한다.  마지막 mapping이 풀리거나 frame이 evict될 때 table에서
+ * 빠진다.
+ * EFILESYS에서는 이 table이 page cache의 색인이 된다.  frame마다 맨 앞에
+ * 어느 process에도 속하지 않는 VM_PAGE_CACHE page가 붙어서, mapping이
+ * 모두 풀려도 frame은 evict될 때까지 남고 read()와 write()도 같은
+ * frame을 읽고 쓴다(filesys/page_cache.c).  file을 닫았다 다시 열어도
+ * 찾을 수 있게 inode 번호로 찾으며, 지운 file의 page는
+ * vm_cache_drop()으로 버린다. */
+static struct hash file_frames;
+
+/* Zero frame.
+ * 아직 한 번도 쓰지 않은 anonymous page(bss, 큰 0 배열 등)를 읽기만
+ * 하면 frame을 새로 주지 않고 모두 이 frame 하나에 read-only로
+ * 맵핑한다.  처음 쓸 때 vm_handle_wp에서 자기 frame을 받는다.
+ * frame table에 넣지 않으므로 evict되지 않고, ref_cnt를 1 더 가지고
+ * 시작해서 맵핑이 하나뿐이어도 공유 중인 frame으로 다뤄진다. */
+static struct frame zero_frame;
+
+/* Same-page merging.
+ * KSMD가 frame table을 돌면서 내용이 같은 anonymous frame을 하나로
+ * 합친다.  두 번 연속 같은 checksum이 나온 frame만 후보로 삼아 자주
+ * 바뀌는 frame은 건드리지 않는다.  후보는 모든 맵핑을 read-only로
+ * 바꾼 뒤 KSM_TABLE에서 같은 checksum의 frame을 찾아 memcmp로 확인하고,
+ * 같으면 page들을 그 frame으로 옮긴다(이후 쓰기는 COW로 떼어진다).
+ * 짝이 없으면 read-only인 채로 KSM_TABLE에 올려서 다음 후보를 기다린다.
+ * 합쳐진 frame도 다른 공유 frame처럼 evict되며, 그러면 KSM_TABLE에서
+ * 빠지고 page들은 swap slot 하나를 같이 가리킨다.
+ * KSM_TABLE과 KSM_HAND는 FRAME_LOCK이 보호한다. */
+#define KSM_BATCH 16 /* Frames scanned per frame_lock hold. */
+bool vm_ksm;
+unsigned vm_ksm_budget = 20;
+static struct hash ksm_table;
+static struct list_elem *ksm_hand; /* Next frame to scan, or NULL. */
+
+/* Eviction statistics. */
+static uint64_t evict_cnt;		/* Frames evicted. */
+static uint64_t evict_cycles;	/* Total TSC cycles spent evicting. */
+static uint64_t evict_scan_cnt; /* Frames the clock hand passed over. */
+
+/* Fault-around: 파일에서 내용을 읽어 오는 page에 read fault가 나면
+ * 뒤따르는 page를 최대 이만큼 같이 올려서 맵핑한다.  연속된 sector는
+ * buffer cache의 read-ahead로 한 번에 읽히므로 fault 한 번 값에
+ * 여러 page를 얻는다.  0이면 끈다. */
+size_t vm_fault_around = 8;
+
+/* User stack가 자랄 수 있는 최대 크기.  USER_STACK 아래로 이 범위
+ * 안에서, rsp 근처에 난 fault만 stack 접근으로 보고 page를 만든다. */
+size_t vm_stack_limit = 1 << 20;
+
+/* SPT를 radix tree 대신 hash table로 만든다. */
+bool vm_spt_hash;
+
+/* Fault statistics. */
+static uint64_t fault_cnt;		  /* Faults handled. */
+static uint64_t fault_cycles;	  /* Total TSC cycles spent on faults. */
+static uint64_t fault_around_cnt; /* Pages mapped ahead by fault-around. */
+static uint64_t stack_grow_cnt;	  /* Faults that grew a stack. */
+static uint64_t stack_page_cnt;	  /* Stack pages added by those faults. */
+static uint64_t stack_cycles;	  /* Total TSC cycles spent growing. */
+
+/* Copy-on-write statistics. */
+static uint64_t cow_share_cnt; /* Pages shared with a child at fork. */
+static uint64_t cow_lazy_cnt;  /* Pages copied at fork without loading. */
+static uint64_t cow_copy_cnt;  /* Shared frames copied on write. */
+
+/* Same-page merging statistics. */
+static uint64_t ksm_scan_cnt;  /* Frames scanned. */
+static uint64_t ksm_merge_cnt; /* Frames reclaimed by merging. */
+static uint64_t ksm_cycles;	   /* Total TSC cycles spent scanning. */
+static int64_t ksm_start;	   /* Tick the daemon started scanning. */
+
+/* Zero frame statistics. */
+static uint64_t zero_map_cnt;  /* Read faults served by the zero frame. */
+static uint64_t zero_copy_cnt; /* Of those, pages later written. */
+
+/* mmap statistics. */
+static uint64_t file_share_cnt; /* File pages mapped from a resident frame. */
+
+static uint64_t file_frame_hash(const struct hash_elem *e, void *aux);
+static bool file_frame_less(const struct hash_elem *a,
+							const struct hash_elem *b, void *aux);
+static uint64_t ksm_hash(const struct hash_elem *e, void *aux);
+static bool ksm_less(const struct hash_elem *a,
+					 const struct hash_elem *b, void *aux);
+static void ksmd(void *aux);
+
+/* Returns the running process's page fault count in RAX, for
+ * get_page_fault_cnt() in user programs. */
+static void
+inspect_fault_cnt(struct intr_frame *f)
+{
+	f->R.rax = thread_current()->page_fault_cnt;
+}
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -21,6 +134,60 @@ void vm_init(void)
 	register_inspect_intr();
 	/* DO NOT MODIFY UPPER LINES. */
 	/* TODO: Your code goes here. */
+	list_init(&frame_list);
+	lock_init(&frame_lock);
+	hash_init(&file_frames, file_frame_hash, file_frame_less, NULL);
+	zero_frame.kva = palloc_get_page(PAL_ZERO);
+	if (zero_frame.kva == NULL)
+		PANIC("cannot allocate the zero frame");
+	list_init(&zero_frame.pages);
+	zero_frame.ref_cnt = 1;
+	zero_frame.pinned = true;
+	zero_frame.file_listed = false;
+	hash_init(&ksm_table, ksm_hash, ksm_less, NULL);
+	if (vm_ksm)
+		thread_create("ksmd", PRI_DEFAULT, ksmd, NULL);
+	clock_hand = NULL;
+	intr_register_int(0x45, 3, INTR_OFF, inspect_fault_cnt,
+					  "Inspect Page Fault Count");
+#ifdef EFILESYS
+	/* frame table이 준비되었으니 이제부터 file I/O는 page cache를 거친다. */
+	page_cache_enabled = true;
+#endif
+}
+
+/* Prints frame table and eviction statistics. */
+void vm_print_stats(void)
+{
+	printf("VM: %zu frames, %llu evictions, %llu frames scanned, "
+		   "%llu cycles per eviction\n",
+		   frame_cnt, evict_cnt, evict_scan_cnt,
+		   evict_cnt != 0 ? evict_cycles / evict_cnt : 0);
+	printf("VM: %llu page faults, %llu cycles per fault, "
+		   "%llu pages mapped by fault-around (%s SPT)\n",
+		   fault_cnt, fault_cnt != 0 ? fault_cycles / fault_cnt : 0,
+		   fault_around_cnt, vm_spt_hash ? "hash" : "radix");
+	printf("VM: %llu stack growth faults, %llu stack pages, "
+		   "%llu cycles per growth\n",
+		   stack_grow_cnt, stack_page_cnt,
+		   stack_grow_cnt != 0 ? stack_cycles / stack_grow_cnt : 0);
+	printf("COW: %llu pages shared at fork, %llu left unloaded, "
+		   "%llu copied on write\n",
+		   cow_share_cnt, cow_lazy_cnt, cow_copy_cnt);
+	printf("VM: %llu zero-page mappings, %llu later written, "
+		   "%llu frames saved\n",
+		   zero_map_cnt, zero_copy_cnt, zero_map_cnt - zero_copy_cnt);
+	printf("KSM: %llu frames scanned (%llu per second), "
+		   "%llu frames reclaimed, %llu cycles scanning\n",
+		   ksm_scan_cnt,
+		   ksm_start != 0 ? ksm_scan_cnt * TIMER_FREQ / (timer_elapsed(ksm_start) + 1) : 0,
+		   ksm_merge_cnt, ksm_cycles);
+	printf("MMAP: %llu file pages shared with another mapping\n",
+		   file_share_cnt);
+#ifdef EFILESYS
+	page_cache_print_stats();
+#endif
+	vm_anon_print_stats();
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -41,8 +208,49 @@ page_get_type(struct page *page)
 
 /* Helpers */
 static struct frame *vm_get_victim(void);
+static bool frame_test_accessed(struct frame *f);
+static bool frame_swap_out(struct frame *victim);
 static bool vm_do_claim_page(struct page *page);
+static bool vm_claim_page_frame(struct page *page, bool may_evict);
+static bool vm_claim_file_page(struct page *page, struct file_page *fp,
+							   bool may_evict);
+static struct file_page *file_page_of(struct page *page);
+static struct frame *file_frame_find(disk_sector_t inumber, off_t ofs);
+static void file_frame_forget(struct frame *frame);
+static bool page_is_user(struct page *page);
+#ifdef EFILESYS
+static bool cache_frame_dirty(struct frame *frame);
+#endif
 static struct frame *vm_evict_frame(void);
+static struct frame *vm_alloc_frame(void);
+static bool vm_install_frame(struct page *page, struct frame *frame);
+static bool vm_pin_page(void *va, bool write);
+static void vm_unpin_range(uint8_t *start, uint8_t *end);
+static bool vm_handle_fault(struct intr_frame *f, void *addr, bool user,
+							bool write, bool not_present);
+static bool fault_around_candidate(struct page *page);
+static bool zero_page_candidate(struct page *page);
+static bool vm_map_zero_page(struct page *page);
+static bool ksm_scan(void);
+static bool ksm_merge_frame(struct frame *f);
+static void ksm_protect(struct frame *f);
+static void ksm_forget(struct frame *f);
+static void vm_fault_around_pages(struct page *page);
+static void vm_free_frame(struct frame *frame);
+static void frame_link(struct frame *frame, struct page *page);
+static void frame_unlink(struct frame *frame, struct page *page);
+static void vm_remap(struct page *page, void *kva, bool writable);
+static void spt_destroy_page(struct page *page);
+static void **spt_slot(struct supplemental_page_table *spt, void *va,
+					   bool create);
+static bool spt_node_walk(struct spt_node *node, int level,
+						  bool (*action)(struct page *, void *), void *aux);
+static void spt_node_clear(struct spt_node *node, int level);
+static bool spt_copy_page(struct page *src_page, void *dst_);
+static bool spt_copy_unloaded(struct page *src, struct page *dst);
+static uint64_t page_hash(const struct hash_elem *p_elem, void *aux);
+static bool page_less(const struct hash_elem *p_elem_a,
+					  const struct hash_elem *p_elem_b, void *aux);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -54,6 +262,8 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 	ASSERT(VM_TYPE(type) != VM_UNINIT)
 
 	struct supplemental_page_table *spt = &thread_current()->spt;
+	bool (*initializer)(struct page *, enum vm_type, void *);
+	struct page *page;
 
 	/* Check wheter the upage is already occupied or not. */
 	if (spt_find_page(spt, upage) == NULL)
@@ -61,8 +271,38 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 		/* TODO: Create the page, fetch the initialier according to the VM type,
 		 * TODO: and then create "uninit" page struct by calling uninit_new. You
 		 * TODO: should modify the field after calling the uninit_new. */
+		switch (VM_TYPE(type))
+		{
+		case VM_ANON:
+			initializer = anon_initializer;
+			break;
+		case VM_FILE:
+			initializer = file_backed_initializer;
+			break;
+#ifdef EFILESYS
+		case VM_PAGE_CACHE:
+			initializer = page_cache_initializer;
+			break;
+#endif
+		default:
+			goto err;
+		}
+
+		page = malloc(sizeof *page);
+		if (page == NULL)
+			goto err;
+		uninit_new(page, pg_round_down(upage), init, type, aux, initializer);
+		// uninit_new이 page 전체를 덮어쓰므로 그 뒤에 채운다.
+		page->writable = writable;
+		page->owner = thread_current();
 
 		/* TODO: Insert the page into the spt. */
+		if (!spt_insert_page(spt, page))
+		{
+			free(page);
+			goto err;
+		}
+		return true;
 	}
 err:
 	return false;
@@ -76,11 +316,18 @@ spt_find_page(struct supplemental_page_table *spt UNUSED, void *va UNUSED)
 {
 	struct page temp_page;
 	struct hash_elem *elem_found;
+	void **slot;
 
 	// 사용자가 요청하는 va는 반드시 page의 시작점이라는 보장이 없기 때문에
 	// pg_round_down함수로 페이지 시작점을 찾는다.
 	va = pg_round_down(va);
 
+	if (spt->spt_hash_table == NULL)
+	{
+		slot = spt_slot(spt, va, false);
+		return slot != NULL ? *slot : NULL;
+	}
+
 	temp_page.va = va;
 	elem_found = hash_find(spt->spt_hash_table, &(temp_page.p_hash_elem));
 	return elem_found != NULL ? hash_entry(elem_found, struct page, p_hash_elem) : NULL;
@@ -92,37 +339,387 @@ spt_find_page(struct supplemental_page_table *spt UNUSED, void *va UNUSED)
 bool spt_insert_page(struct supplemental_page_table *spt UNUSED,
 					 struct page *page UNUSED)
 {
-	struct hash_elem *result = NULL;
-	if (!spt_find_page(spt, page->va))
-		result = hash_insert(spt->spt_hash_table, &(page->p_hash_elem));
-	return result != NULL ? true : false;
+	void **slot;
+
+	if (vm_spt_hash && spt->spt_hash_table == NULL)
+	{
+		spt->spt_hash_table = malloc(sizeof *spt->spt_hash_table);
+		if (spt->spt_hash_table == NULL)
+			return false;
+		hash_init(spt->spt_hash_table, page_hash, page_less, NULL);
+	}
+
+	if (spt->spt_hash_table == NULL)
+	{
+		slot = spt_slot(spt, page->va, true);
+		if (slot == NULL || *slot != NULL)
+			return false;
+		*slot = page;
+		return true;
+	}
+
+	// hash_insert는 같은 va의 page가 이미 있으면 그 elem을, 없으면 NULL을 반환한다.
+	return hash_insert(spt->spt_hash_table, &(page->p_hash_elem)) == NULL;
 }
 
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
 {
-	vm_dealloc_page(page);
+	if (spt->spt_hash_table == NULL)
+		*spt_slot(spt, page->va, false) = NULL;
+	else
+		hash_delete(spt->spt_hash_table, &page->p_hash_elem);
+	spt_destroy_page(page);
+}
+
+/* Returns the slot of the radix-tree SPT that holds the page at VA,
+ * which must be page-aligned.  If a node on the way is missing,
+ * returns NULL or, if CREATE is true, allocates it; returns NULL if
+ * that fails. */
+static void **
+spt_slot(struct supplemental_page_table *spt, void *va, bool create)
+{
+	size_t idx[] = {PML4(va), PDPE(va), PDX(va)};
+	struct spt_node **node = &spt->root;
+	size_t i;
+
+	for (i = 0;; i++)
+	{
+		if (*node == NULL)
+		{
+			if (!create || (*node = palloc_get_page(PAL_ZERO)) == NULL)
+				return NULL;
+		}
+		if (i == sizeof idx / sizeof *idx)
+			return &(*node)->slots[PTX(va)];
+		node = (struct spt_node **)&(*node)->slots[idx[i]];
+	}
+}
+
+/* Calls ACTION(PAGE, AUX) for each page in the subtree NODE, at
+ * LEVEL levels above the pages, in order of address.  Stops and
+ * returns false as soon as ACTION returns false. */
+static bool
+spt_node_walk(struct spt_node *node, int level,
+			  bool (*action)(struct page *, void *), void *aux)
+{
+	size_t i;
+
+	for (i = 0; i < SPT_SLOTS; i++)
+	{
+		if (node->slots[i] == NULL)
+			continue;
+		if (level == 0 ? !action(node->slots[i], aux)
+					   : !spt_node_walk(node->slots[i], level - 1, action, aux))
+			return false;
+	}
 	return true;
 }
 
+/* Destroys every page in the subtree NODE, at LEVEL levels above the
+ * pages, and frees NODE. */
+static void
+spt_node_clear(struct spt_node *node, int level)
+{
+	size_t i;
+
+	for (i = 0; i < SPT_SLOTS; i++)
+	{
+		if (node->slots[i] == NULL)
+			continue;
+		if (level == 0)
+			spt_destroy_page(node->slots[i]);
+		else
+			spt_node_clear(node->slots[i], level - 1);
+	}
+	palloc_free_page(node);
+}
+
+/* Returns true if PAGE is linked to a frame that is pinned, that is,
+ * one that is being filled, merged or evicted, so that PAGE must be
+ * left alone until that settles.  FRAME_LOCK must be held. */
+static bool
+page_frame_busy(struct page *page)
+{
+	return page->frame != NULL && page->frame != &zero_frame
+		   && page->frame->pinned;
+}
+
+/* Waits until page_frame_busy(PAGE) is false.  FRAME_LOCK must be
+ * held; it is released while waiting. */
+static void
+page_frame_wait(struct page *page)
+{
+	while (page_frame_busy(page))
+	{
+		lock_release(&frame_lock);
+		thread_yield();
+		lock_acquire(&frame_lock);
+	}
+}
+
+/* Destroys PAGE and gives its frame, if any, back to the user pool.
+ * The page is destroyed under FRAME_LOCK while it is still mapped,
+ * so that eviction cannot take the frame away meanwhile and a file
+ * page can still consult its dirty bit for writeback.  A frame still
+ * shared with other pages only loses PAGE's mapping; otherwise it is
+ * pinned and freed once the lock is released. */
+static void
+spt_destroy_page(struct page *page)
+{
+	struct frame *frame;
+
+	lock_acquire(&frame_lock);
+	page_frame_wait(page);
+	destroy(page);
+	frame = page->frame;
+	if (frame != NULL)
+	{
+		pml4_clear_page(page->owner->pml4, page->va);
+		frame_unlink(frame, page);
+		if (frame->ref_cnt == 0)
+			frame->pinned = true;
+		else
+			frame = NULL;
+	}
+	lock_release(&frame_lock);
+
+	free(page);
+	if (frame != NULL)
+		vm_free_frame(frame);
+}
+
+/* Makes PAGE one of the pages mapping FRAME.  FRAME must be pinned
+ * or FRAME_LOCK held. */
+static void
+frame_link(struct frame *frame, struct page *page)
+{
+	list_push_back(&frame->pages, &page->frame_elem);
+	frame->ref_cnt++;
+	frame->page = list_entry(list_front(&frame->pages), struct page, frame_elem);
+	page->frame = frame;
+}
+
+/* Undoes frame_link(FRAME, PAGE).  FRAME must be pinned or
+ * FRAME_LOCK held. */
+static void
+frame_unlink(struct frame *frame, struct page *page)
+{
+	ASSERT(page->frame == frame);
+
+	list_remove(&page->frame_elem);
+	frame->ref_cnt--;
+	frame->page = list_empty(&frame->pages)
+					  ? NULL
+					  : list_entry(list_front(&frame->pages), struct page, frame_elem);
+	page->frame = NULL;
+}
+
+/* PAGE의 owner pml4에서 PAGE를 KVA로 다시 맵핑한다.  이미 맵핑되어
+ * 있어도 되며, 먼저 지워서 TLB에 남은 옛 entry도 무효화한다. */
+static void
+vm_remap(struct page *page, void *kva, bool writable)
+{
+	uint64_t *pml4 = page->owner->pml4;
+
+	pml4_clear_page(pml4, page->va);
+	if (!pml4_set_page(pml4, page->va, kva, writable))
+		PANIC("page table allocation failed while remapping");
+}
+
+/* Returns the frame after E in clock order, wrapping around at the
+ * end of FRAME_LIST. */
+static struct list_elem *
+clock_next(struct list_elem *e)
+{
+	e = list_next(e);
+	return e == list_end(&frame_list) ? list_begin(&frame_list) : e;
+}
+
 /* Get the struct frame, that will be evicted. */
+/* Second-chance(clock) 정책.
+ * 바늘이 가리키는 frame의 accessed bit가 켜져 있으면 끄고 넘어가고,
+ * 꺼져 있으면 victim으로 고른다.  첫 바퀴에서 모든 bit를 끄게 되므로
+ * 두 바퀴 안에 반드시 victim이 나오고, 그래서 검사 횟수는 frame 수의
+ * 두 배로 제한된다.  그 안에 찾지 못하면(모든 frame이 pinned) NULL.
+ * FRAME_LOCK을 잡은 채로 호출해야 한다. */
 static struct frame *
 vm_get_victim(void)
 {
 	struct frame *victim = NULL;
-	/* TODO: The policy for eviction is up to you. */
+	size_t i;
+
+	ASSERT(lock_held_by_current_thread(&frame_lock));
+
+	for (i = 0; i < 2 * frame_cnt; i++)
+	{
+		struct frame *f = list_entry(clock_hand, struct frame, f_elem);
 
+		clock_hand = clock_next(clock_hand);
+		evict_scan_cnt++;
+
+		/* 공유 중인 frame은 맵핑한 page 중 하나라도 접근했으면
+		 * 최근에 쓰인 것으로 본다. */
+		if (f->pinned || f->io_pin_cnt > 0 || f->ref_cnt == 0
+			|| frame_test_accessed(f))
+			continue;
+		victim = f;
+		break;
+	}
 	return victim;
 }
 
+/* Returns true if any page mapping F has been accessed since the
+ * last call, and clears their accessed bits.  FRAME_LOCK must be
+ * held. */
+static bool
+frame_test_accessed(struct frame *f)
+{
+	struct list_elem *e;
+	bool accessed = false;
+
+	for (e = list_begin(&f->pages); e != list_end(&f->pages); e = list_next(e))
+	{
+		struct page *page = list_entry(e, struct page, frame_elem);
+		uint64_t *pml4;
+
+		if (!page_is_user(page))
+		{
+#ifdef EFILESYS
+			/* read()와 write()는 page cache page에 표시한다. */
+			accessed |= page->page_cache.accessed;
+			page->page_cache.accessed = false;
+#endif
+			continue;
+		}
+		pml4 = page->owner->pml4;
+		if (pml4_is_accessed(pml4, page->va))
+		{
+			pml4_set_accessed(pml4, page->va, false);
+			accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* Writes out VICTIM, a pinned frame whose pages are all unmapped, on
+ * behalf of every page mapping it.  An anonymous frame goes to one
+ * swap slot that all of its pages share.  Each page of a file frame
+ * writes it back if that page dirtied it, and then reads it from the
+ * file again.  A page cache frame is written back once, by its page
+ * cache page, if it or any mapping dirtied it.  Returns false if
+ * there is no free swap slot. */
+static bool
+frame_swap_out(struct frame *victim)
+{
+	struct page *first = victim->page;
+	struct list_elem *e;
+
+#ifdef EFILESYS
+	if (first->operations->type == VM_PAGE_CACHE)
+	{
+		cache_frame_dirty(victim);
+		return swap_out(first);
+	}
+#endif
+	if (!swap_out(first))
+		return false;
+	for (e = list_next(&first->frame_elem); e != list_end(&victim->pages);
+		 e = list_next(e))
+	{
+		struct page *page = list_entry(e, struct page, frame_elem);
+
+		if (page->operations->type == VM_ANON)
+			anon_share_slot(page, first);
+		else
+			swap_out(page);
+	}
+	return true;
+}
+
 /* Evict one page and return the corresponding frame.
  * Return NULL on error.*/
+/* 반환되는 frame은 frame table에 남아 있고 pinned 상태이다.
+ * swap_out()의 disk I/O는 FRAME_LOCK 없이 한다.  그래야 swap disk에
+ * 쓰는 동안에도 다른 channel의 file system disk를 읽는 fault나 I/O가
+ * 없는 fault가 기다리지 않는다.  victim은 pin하고 맵핑을 내려 둔다.
+ * PTE의 dirty bit는 pml4_clear_page() 뒤에도 남으므로 writeback
+ * 판단에 그대로 쓸 수 있고, 그 사이 page를 건드리는 fault, fork,
+ * 해제는 page_frame_wait()으로 기다린다.  공유 frame은 맵핑한 page를
+ * 모두 내리고 한 번만 내보낸다. */
 static struct frame *
 vm_evict_frame(void)
 {
-	struct frame *victim UNUSED = vm_get_victim();
-	/* TODO: swap out the victim and return the evicted frame. */
+	uint64_t start = rdtsc();
+	struct frame *victim;
+	struct page *cache = NULL;
+	struct list_elem *e;
+	bool ok;
 
-	return NULL;
+	lock_acquire(&frame_lock);
+	victim = vm_get_victim();
+	if (victim == NULL)
+	{
+		lock_release(&frame_lock);
+		return NULL;
+	}
+	victim->pinned = true;
+	for (e = list_begin(&victim->pages); e != list_end(&victim->pages); e = list_next(e))
+	{
+		struct page *page = list_entry(e, struct page, frame_elem);
+
+		if (page_is_user(page))
+			pml4_clear_page(page->owner->pml4, page->va);
+	}
+	lock_release(&frame_lock);
+
+	ok = frame_swap_out(victim);
+
+	lock_acquire(&frame_lock);
+	if (ok)
+	{
+		/* page cache page는 frame과 함께 사라진다.  mapping한 page는
+		 * 다음 fault에서 page cache에 다시 읽어 온다. */
+		if (!page_is_user(victim->page))
+			cache = victim->page;
+		while (!list_empty(&victim->pages))
+			frame_unlink(victim,
+						 list_entry(list_front(&victim->pages), struct page, frame_elem));
+		file_frame_forget(victim);
+		ksm_forget(victim);
+		evict_cnt++;
+		evict_cycles += rdtsc() - start;
+	}
+	else
+	{
+		/* 내보내지 못했으면 다시 맵핑한다.  공유되지 않은 frame과
+		 * file frame은 원래 권한대로 쓰되, 그러려면 merge 대상
+		 * 목록에서는 빠져야 한다.  공유 중인 anonymous frame은
+		 * copy-on-write이므로 read-only로 둔다. */
+		ksm_forget(victim);
+		for (e = list_begin(&victim->pages); e != list_end(&victim->pages);
+			 e = list_next(e))
+		{
+			struct page *page = list_entry(e, struct page, frame_elem);
+			bool dirty;
+
+			if (!page_is_user(page))
+				continue;
+			dirty = pml4_is_dirty(page->owner->pml4, page->va);
+
+			vm_remap(page, victim->kva,
+					 page->writable
+						 && (victim->ref_cnt == 1 || page_get_type(page) == VM_FILE));
+			if (dirty)
+				pml4_set_dirty(page->owner->pml4, page->va, true);
+		}
+		victim->pinned = false;
+		victim = NULL;
+	}
+	lock_release(&frame_lock);
+
+	if (cache != NULL)
+		vm_dealloc_page(cache);
+	return victim;
 }
 
 /* palloc() and get frame. If there is no available page, evict the page
@@ -132,54 +729,504 @@ vm_evict_frame(void)
 /* palloc을 kernel pool에서 받게 된다면, 예상치 못하게 테스트 케이스에서 실패할 수 있다.
  반드시 user pool에서 할당받아야 한다.
  이 함수로 모든 유저 공간(user pool) page들을 할당한다.
+ 반환된 frame은 pinned 상태이므로 page를 다 채운 뒤 pinned를 풀어야 한다.
+ 모든 frame이 pinned여서 eviction도 할 수 없으면 NULL을 반환한다.
 */
 static struct frame *
 vm_get_frame(void)
+{
+	struct frame *frame = vm_alloc_frame();
+
+	return frame != NULL ? frame : vm_evict_frame();
+}
+
+/* vm_get_frame()과 같지만 evict하지 않는다.  user pool이 비어 있으면
+ * NULL을 반환한다. */
+static struct frame *
+vm_alloc_frame(void)
 {
 	struct frame *frame = NULL;
-	/* TODO: Fill this function. */
+	void *kva;
+
 	// user pool에서 할당받는다.
-	frame = palloc_get_page(PAL_USER);
+	kva = palloc_get_page(PAL_USER);
+	if (kva == NULL)
+		return NULL;
 
-	// 지금은 일단 swap out 구현 전이기 때문에 todo로 표시
-	if (!frame)
-		PANIC("todo");
+	frame = malloc(sizeof *frame);
+	if (frame == NULL)
+	{
+		palloc_free_page(kva);
+		return NULL;
+	}
 
 	// frame 초기화
-	frame->kva = ptov(frame);
+	frame->kva = kva;
 	frame->page = NULL;
+	list_init(&frame->pages);
+	frame->ref_cnt = 0;
+	frame->pinned = true;
+	frame->io_pin_cnt = 0;
+	frame->file_listed = false;
+	frame->ksm_sum = 0;
+	frame->ksm_listed = false;
 
-	// 할당한 frame 을 frame_list에 추가
-	list_push_back(&frame_list, &frame->f_elem);
+	// 할당한 frame을 frame table의 시계 바늘 바로 뒤에 추가
+	lock_acquire(&frame_lock);
+	if (clock_hand == NULL)
+	{
+		list_push_back(&frame_list, &frame->f_elem);
+		clock_hand = &frame->f_elem;
+	}
+	else
+		list_insert(clock_hand, &frame->f_elem);
+	frame_cnt++;
+	lock_release(&frame_lock);
 
-	ASSERT(frame != NULL);
 	ASSERT(frame->page == NULL);
 
 	return frame;
 }
 
-/* Growing the stack. */
+/* Removes FRAME, which must be pinned, from the frame table and
+ * returns its memory to the user pool. */
+static void
+vm_free_frame(struct frame *frame)
+{
+	ASSERT(frame->pinned);
+	ASSERT(frame->ref_cnt == 0);
+
+	lock_acquire(&frame_lock);
+	file_frame_forget(frame);
+	ksm_forget(frame);
+	if (clock_hand == &frame->f_elem)
+		clock_hand = frame_cnt > 1 ? clock_next(clock_hand) : NULL;
+	if (ksm_hand == &frame->f_elem)
+	{
+		ksm_hand = list_next(ksm_hand);
+		if (ksm_hand == list_end(&frame_list))
+			ksm_hand = NULL;
+	}
+	list_remove(&frame->f_elem);
+	frame_cnt--;
+	lock_release(&frame_lock);
+
+	palloc_free_page(frame->kva);
+	free(frame);
+}
+
+/* Same-page merging daemon.  Scans KSM_BATCH frames at a time and
+ * keeps the CPU time it uses within VM_KSM_BUDGET ms in each second.
+ * The TSC rate is unknown, so it is measured against the timer
+ * first.  Once a full pass over the frame table is done, or the
+ * budget is used up, the daemon sleeps until the next second. */
 static void
-vm_stack_growth(void *addr UNUSED)
+ksmd(void *aux UNUSED)
 {
+	int64_t window = timer_ticks();
+	uint64_t start = rdtsc();
+	uint64_t budget;
+
+	timer_sleep(TIMER_FREQ / 10);
+	budget = (rdtsc() - start) / timer_elapsed(window) * TIMER_FREQ
+			 * vm_ksm_budget / 1000;
+	ksm_start = timer_ticks();
+
+	for (;;)
+	{
+		uint64_t used = 0;
+		bool done = false;
+
+		window = timer_ticks();
+		while (!done && used < budget)
+		{
+			start = rdtsc();
+			done = ksm_scan();
+			used += rdtsc() - start;
+			thread_yield();
+		}
+		ksm_cycles += used;
+
+		if (timer_elapsed(window) < TIMER_FREQ)
+			timer_sleep(TIMER_FREQ - timer_elapsed(window));
+	}
+}
+
+/* Scans up to KSM_BATCH frames from KSM_HAND, merging those that
+ * can be merged.  Returns true if the scan reached the end of the
+ * frame table. */
+static bool
+ksm_scan(void)
+{
+	struct frame *freed[KSM_BATCH];
+	size_t freed_cnt = 0;
+	bool done = false;
+	size_t i;
+
+	lock_acquire(&frame_lock);
+	for (i = 0; i < KSM_BATCH && !done; i++)
+	{
+		struct frame *f;
+
+		if (list_empty(&frame_list))
+		{
+			done = true;
+			break;
+		}
+		if (ksm_hand == NULL)
+			ksm_hand = list_begin(&frame_list);
+		f = list_entry(ksm_hand, struct frame, f_elem);
+		ksm_hand = list_next(ksm_hand);
+		if (ksm_hand == list_end(&frame_list))
+		{
+			ksm_hand = NULL;
+			done = true;
+		}
+
+		ksm_scan_cnt++;
+		if (ksm_merge_frame(f))
+			freed[freed_cnt++] = f;
+	}
+	lock_release(&frame_lock);
+
+	for (i = 0; i < freed_cnt; i++)
+		vm_free_frame(freed[i]);
+	return done;
+}
+
+/* Merges F into a listed frame with the same contents, or lists F
+ * as a merge target, if F is a stable anonymous frame.  Returns true
+ * if F was merged: it is then pinned and unused, and the caller
+ * must free it.  FRAME_LOCK must be held. */
+static bool
+ksm_merge_frame(struct frame *f)
+{
+	struct frame *g, key;
+	struct hash_elem *e;
+	uint64_t sum;
+
+	if (f->pinned || f->io_pin_cnt > 0 || f->ref_cnt == 0 || f->ksm_listed
+		|| f->page->operations->type != VM_ANON)
+		return false;
+
+	/* 지난번과 checksum이 다르면 아직 쓰이고 있는 frame이다. */
+	sum = hash_bytes(f->kva, PGSIZE);
+	if (sum != f->ksm_sum)
+	{
+		f->ksm_sum = sum;
+		return false;
+	}
+
+	key.ksm_sum = sum;
+	e = hash_find(&ksm_table, &key.ksm_elem);
+	g = e != NULL ? hash_entry(e, struct frame, ksm_elem) : NULL;
+	if (g != NULL && (g->pinned || g->ref_cnt == 0))
+		return false;
+
+	/* 쓰기를 막은 뒤에 내용을 다시 확인한다. */
+	ksm_protect(f);
+	if (g == NULL)
+	{
+		if (hash_bytes(f->kva, PGSIZE) == sum)
+		{
+			hash_insert(&ksm_table, &f->ksm_elem);
+			f->ksm_listed = true;
+		}
+		return false;
+	}
+	if (memcmp(f->kva, g->kva, PGSIZE) != 0)
+		return false;
+
+	while (!list_empty(&f->pages))
+	{
+		struct page *page = list_entry(list_front(&f->pages), struct page, frame_elem);
+
+		frame_unlink(f, page);
+		frame_link(g, page);
+		vm_remap(page, g->kva, false);
+	}
+	f->pinned = true;
+	ksm_merge_cnt++;
+	return true;
+}
+
+/* Maps every page of F read-only, so that a write to any of them
+ * faults into vm_handle_wp().  FRAME_LOCK must be held. */
+static void
+ksm_protect(struct frame *f)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&f->pages); e != list_end(&f->pages); e = list_next(e))
+		vm_remap(list_entry(e, struct page, frame_elem), f->kva, false);
+}
+
+/* Removes F from KSM_TABLE if it is there.  FRAME_LOCK must be
+ * held. */
+static void
+ksm_forget(struct frame *f)
+{
+	if (!f->ksm_listed)
+		return;
+	hash_delete(&ksm_table, &f->ksm_elem);
+	f->ksm_listed = false;
+}
+
+/* Returns true if a fault at ADDR by a thread whose user stack
+ * pointer is RSP is a stack access: ADDR lies within VM_STACK_LIMIT
+ * below USER_STACK and no lower than RSP - 8, where PUSH writes
+ * before it moves the stack pointer. */
+bool vm_is_stack_access(void *addr, uintptr_t rsp)
+{
+	uintptr_t va = (uintptr_t)addr;
+
+	return va < USER_STACK && va >= USER_STACK - vm_stack_limit
+		   && va + 8 >= rsp;
+}
+
+/* Growing the stack. */
+/* ADDR가 들어 있는 page부터 현재 stack의 맨 아래 page 바로 앞까지를
+ * 한꺼번에 stack page로 만든다.  큰 지역 변수처럼 stack 바닥보다 한참
+ * 아래에서 fault가 나도 사이의 page마다 fault를 다시 받지 않도록,
+ * fault난 page를 올린 뒤 나머지도 빈 frame이 있는 만큼 미리 맵핑한다.
+ * 미리 맵핑하지 못한 page는 spt에 남아 있다가 처음 접근할 때 올라온다. */
+static bool
+vm_stack_growth(void *addr)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint64_t start = rdtsc();
+	uint8_t *bottom = pg_round_down(addr);
+	uint8_t *top, *va;
+
+	for (top = bottom; top < (uint8_t *)USER_STACK; top += PGSIZE)
+	{
+		if (spt_find_page(spt, top) != NULL)
+			break;
+		if (!vm_alloc_page(VM_ANON | VM_STACK, top, true))
+			break;
+	}
+	if (top == bottom || !vm_claim_page(bottom))
+		return false;
+	for (va = bottom + PGSIZE; va < top; va += PGSIZE)
+		if (!vm_claim_page_frame(spt_find_page(spt, va), false))
+			break;
+
+	stack_grow_cnt++;
+	stack_page_cnt += (top - bottom) / PGSIZE;
+	stack_cycles += rdtsc() - start;
+	return true;
 }
 
 /* Handle the fault on write_protected page */
+/* Copy-on-write.  PAGE는 논리적으로 writable이지만 frame을 공유하고 있어
+ * read-only로 맵핑되어 있다.  공유가 이미 풀렸으면 writable로 다시
+ * 맵핑만 하고, 아니면 새 frame에 내용을 복사해서 떼어낸다.  새 frame은
+ * FRAME_LOCK 밖에서 받아 두고(eviction이 lock을 잡으므로), 복사는
+ * lock을 잡은 채로 해서 그동안 공유 frame이 해제되거나 evict되지
+ * 않게 한다. */
 static bool
 vm_handle_wp(struct page *page UNUSED)
 {
+	struct frame *old, *new = NULL;
+
+	for (;;)
+	{
+		lock_acquire(&frame_lock);
+		page_frame_wait(page);
+		old = page->frame;
+		if (old == NULL || (old->ref_cnt > 1 && new != NULL))
+			break;
+		if (old->ref_cnt == 1)
+		{
+			/* 쓸 수 있게 되면 내용이 바뀌므로 merge 대상에서 뺀다. */
+			ksm_forget(old);
+			vm_remap(page, old->kva, true);
+			lock_release(&frame_lock);
+			if (new != NULL)
+				vm_free_frame(new);
+			return true;
+		}
+		lock_release(&frame_lock);
+
+		new = vm_get_frame();
+		if (new == NULL)
+			return false;
+	}
+
+	if (old == NULL)
+	{
+		/* Evicted while we were getting a frame: the page is no
+		 * longer shared, so let the caller fault it back in. */
+		lock_release(&frame_lock);
+		if (new != NULL)
+			vm_free_frame(new);
+		return vm_claim_page(page->va);
+	}
+
+	frame_unlink(old, page);
+	frame_link(new, page);
+	if (old == &zero_frame)
+	{
+		/* 처음 쓰는 zero page는 복사할 것 없이 anon page로 초기화한다. */
+		if (!swap_in(page, new->kva))
+		{
+			frame_unlink(new, page);
+			frame_link(old, page);
+			lock_release(&frame_lock);
+			vm_free_frame(new);
+			return false;
+		}
+		zero_copy_cnt++;
+	}
+	else
+	{
+		memcpy(new->kva, old->kva, PGSIZE);
+		cow_copy_cnt++;
+	}
+	vm_remap(page, new->kva, true);
+	new->pinned = false;
+	lock_release(&frame_lock);
+	return true;
+}
+
+/* Returns true if PAGE is an anonymous page that has never been
+ * loaded and starts out zeroed, so that reading it can be served by
+ * the zero frame.  Stack pages are left out: they are written right
+ * away. */
+static bool
+zero_page_candidate(struct page *page)
+{
+	return page->operations->type == VM_UNINIT
+		   && page->frame == NULL
+		   && VM_TYPE(page->uninit.type) == VM_ANON
+		   && !(page->uninit.type & VM_STACK)
+		   && page->uninit.init == NULL;
+}
+
+/* Maps PAGE read-only to the zero frame. */
+static bool
+vm_map_zero_page(struct page *page)
+{
+	bool success;
+
+	lock_acquire(&frame_lock);
+	frame_link(&zero_frame, page);
+	success = pml4_set_page(page->owner->pml4, page->va, zero_frame.kva, false);
+	if (success)
+		zero_map_cnt++;
+	else
+		frame_unlink(&zero_frame, page);
+	lock_release(&frame_lock);
+	return success;
 }
 
 /* Return true on success */
 bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 						 bool user UNUSED, bool write UNUSED, bool not_present UNUSED)
 {
-	struct supplemental_page_table *spt UNUSED = &thread_current()->spt;
-	struct page *page = NULL;
+	uint64_t start = rdtsc();
+	bool success;
+
 	/* TODO: Validate the fault */
-	/* TODO: Your code goes here */
+	if (addr == NULL || is_kernel_vaddr(addr))
+		return false;
 
-	return vm_do_claim_page(page);
+	thread_current()->page_fault_cnt++;
+	fault_cnt++;
+
+	success = vm_handle_fault(f, addr, user, write, not_present);
+	fault_cycles += rdtsc() - start;
+	return success;
+}
+
+/* Handles a fault at ADDR, a user address, for vm_try_handle_fault(). */
+static bool
+vm_handle_fault(struct intr_frame *f, void *addr, bool user, bool write,
+				bool not_present)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct page *page = NULL;
+	bool around, mapped;
+
+	page = spt_find_page(spt, addr);
+	if (page == NULL)
+	{
+		/* syscall 도중 kernel에서 난 fault라면 user rsp는 syscall
+		 * 진입 때 저장해 둔 frame에 있다. */
+		uintptr_t rsp = user ? f->rsp : thread_current()->user_tf.rsp;
+
+		return vm_is_stack_access(addr, rsp) && vm_stack_growth(addr);
+	}
+	if (write && !page->writable)
+		return false;
+
+	/* 맵핑이 있는데 쓰기에서 fault가 났다면 copy-on-write page이다. */
+	if (!not_present)
+		return write && page->frame != NULL && vm_handle_wp(page);
+
+	/* evict되는 중인 page는 끝날 때까지 기다린다.  그래도 frame이 남아
+	 * 있으면 eviction이 실패해서 다시 맵핑된 것이다. */
+	lock_acquire(&frame_lock);
+	page_frame_wait(page);
+	mapped = page->frame != NULL;
+	lock_release(&frame_lock);
+	if (mapped)
+		return true;
+
+	/* 아직 내용이 없는 anonymous page는 읽기만 하는 동안 zero frame을 쓴다. */
+	if (!write && zero_page_candidate(page))
+		return vm_map_zero_page(page);
+
+	around = !write && vm_fault_around > 0 && fault_around_candidate(page);
+	if (!vm_do_claim_page(page))
+		return false;
+	if (around)
+		vm_fault_around_pages(page);
+	return true;
+}
+
+/* Returns true if PAGE has never been loaded and its contents come
+ * from a file, so that loading it next to a faulting neighbour is
+ * cheap: the sectors are contiguous and read ahead by the buffer
+ * cache. */
+static bool
+fault_around_candidate(struct page *page)
+{
+	enum vm_type type;
+
+	if (page->operations->type != VM_UNINIT)
+		return false;
+	type = page->uninit.type;
+	return (type & VM_FILE_INIT) || VM_TYPE(type) == VM_FILE;
+}
+
+/* Maps up to VM_FAULT_AROUND pages following PAGE, a fault-around
+ * candidate that has just been faulted in for reading, as long as
+ * they are candidates too and free frames are available.  Never
+ * evicts: under memory pressure a speculative page is not worth a
+ * resident one. */
+static void
+vm_fault_around_pages(struct page *page)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *va = page->va;
+	size_t i;
+
+	for (i = 0; i < vm_fault_around; i++)
+	{
+		struct page *next;
+
+		va += PGSIZE;
+		if (is_kernel_vaddr(va))
+			break;
+		next = spt_find_page(spt, va);
+		if (next == NULL || next->frame != NULL || !fault_around_candidate(next))
+			break;
+		if (!vm_claim_page_frame(next, false))
+			break;
+		thread_current()->fault_around_cnt++;
+		fault_around_cnt++;
+	}
 }
 
 /* Free the page.
@@ -194,79 +1241,672 @@ void vm_dealloc_page(struct page *page)
 bool vm_claim_page(void *va UNUSED)
 {
 	struct page *page = NULL;
-	/* TODO: Fill this function */
-	page = palloc_get_page(PAL_USER);
-	page->va = va;
-	// 만들어진 페이지는 spt에 추가
-	hash_insert(thread_current()->spt.spt_hash_table, &(page->p_hash_elem));
+
+	page = spt_find_page(&thread_current()->spt, va);
+	if (page == NULL)
+		return false;
 
 	return vm_do_claim_page(page);
 }
 
+/* Keeps the SIZE bytes of user memory at BUFFER mapped, and
+ * writable if WRITE is true, until vm_unpin_buffer().  Returns
+ * false, with nothing pinned, if part of the buffer is not valid
+ * user memory.
+ * read()와 write()는 file system에 들어가기 전에 user buffer를 pin한다.
+ * file system의 lock을 잡고 buffer를 복사하다가 page fault가 나면, page를
+ * 파일에서 읽어 오거나 evict할 frame을 파일에 쓰느라 이미 잡고 있는
+ * inode나 buffer cache entry의 lock을 다시 잡게 된다.  그래서 아직 없는
+ * page는 lock을 잡기 전인 여기서 fault로 올리고, pin한 frame은
+ * evict하거나 merge하지 않는다. */
+bool vm_pin_buffer(const void *buffer, size_t size, bool write)
+{
+	uint8_t *start = pg_round_down(buffer);
+	uint8_t *end = (uint8_t *)buffer + size;
+	uint8_t *va;
+
+	if (end < (uint8_t *)buffer)
+		return false;
+	for (va = start; va < end; va += PGSIZE)
+		if (!vm_pin_page(va, write))
+		{
+			vm_unpin_range(start, va);
+			return false;
+		}
+	return true;
+}
+
+/* Undoes vm_pin_buffer(BUFFER, SIZE, ...). */
+void vm_unpin_buffer(const void *buffer, size_t size)
+{
+	vm_unpin_range(pg_round_down(buffer), (uint8_t *)buffer + size);
+}
+
+/* Pins the page at VA, a page of the running process, for
+ * vm_pin_buffer(), faulting it in first if it is not mapped, or
+ * copying it if WRITE is true and it is mapped read-only for
+ * copy-on-write. */
+static bool
+vm_pin_page(void *va, bool write)
+{
+	struct thread *curr = thread_current();
+
+	if (!is_user_vaddr(va))
+		return false;
+	for (;;)
+	{
+		struct page *page = spt_find_page(&curr->spt, va);
+		bool present = false;
+
+		if (page != NULL)
+		{
+			if (write && !page->writable)
+				return false;
+			lock_acquire(&frame_lock);
+			page_frame_wait(page);
+			present = page->frame != NULL;
+			if (present)
+			{
+				uint64_t *pte = pml4e_walk(curr->pml4, (uint64_t)va, 0);
+
+				if (!write || (pte != NULL && is_writable(pte)))
+				{
+					page->frame->io_pin_cnt++;
+					lock_release(&frame_lock);
+					return true;
+				}
+			}
+			lock_release(&frame_lock);
+		}
+
+		/* 맵핑되어 있는데 read-only이면 copy-on-write page이다.  그 사이
+		 * evict될 수도 있으니 올린 뒤에는 처음부터 다시 확인한다. */
+		if (present ? !vm_handle_wp(page)
+					: !vm_handle_fault(NULL, va, false, write, true))
+			return false;
+	}
+}
+
+/* Unpins the pages of the running process from START, which must
+ * be page-aligned, up to END. */
+static void
+vm_unpin_range(uint8_t *start, uint8_t *end)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *va;
+
+	lock_acquire(&frame_lock);
+	for (va = start; va < end; va += PGSIZE)
+	{
+		struct page *page = spt_find_page(spt, va);
+
+		ASSERT(page != NULL && page->frame != NULL);
+		ASSERT(page->frame->io_pin_cnt > 0);
+		page->frame->io_pin_cnt--;
+	}
+	lock_release(&frame_lock);
+}
+
 /* Claim the PAGE and set up the mmu. */
 /* 인자로 주어진 page에 물리 메모리 프레임을 할당
  */
 static bool
 vm_do_claim_page(struct page *page)
 {
-	struct frame *frame = vm_get_frame();
+	return vm_claim_page_frame(page, true);
+}
 
-	/* Set links */
-	frame->page = page;
-	page->frame = frame;
+/* Gives PAGE a frame and maps it.  File pages reuse the frame of
+ * another mapping of the same file page if there is one.  If
+ * MAY_EVICT is false, fails instead of evicting when the user pool
+ * is exhausted. */
+static bool
+vm_claim_page_frame(struct page *page, bool may_evict)
+{
+	struct file_page *fp = file_page_of(page);
+	struct frame *frame;
 
-	/* TODO: Insert page table entry to map page's VA to frame's PA. */
-	/*
-	page table관련 함수를 사용해서 입력된 page의 시작주소를 frame의 시작주소와 맵핑시킨다.
-	1. pte를 찾는다.
-	2. pte의 PFN값을 vm_get_frame()함수로 할당한 frame의 kva값을 이용해서 설정한다.
-	*/
-	uint64_t *pte_found = pml4e_walk(thread_current()->pml4, page->va, 1);
-	if (pte_found && (*pte_found & PTE_P))
-	{
-		pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->writable);
-		// & ~0xFFF 넣을지 고민
-		*pte_found = vtop(frame->kva);
-		return true;
+	if (fp != NULL)
+		return vm_claim_file_page(page, fp, may_evict);
+
+	frame = may_evict ? vm_get_frame() : vm_alloc_frame();
+	if (frame == NULL)
+		return false;
+	return vm_install_frame(page, frame);
+}
+
+/* Returns the file page PAGE maps, whether or not it has been
+ * loaded yet, or NULL if PAGE is not a VM_FILE page. */
+static struct file_page *
+file_page_of(struct page *page)
+{
+	if (page_get_type(page) != VM_FILE)
+		return NULL;
+	return page->operations->type == VM_UNINIT ? page->uninit.aux : &page->file;
+}
+
+/* Claims PAGE, which maps file page FP.  If the file page is already
+ * resident in some frame, PAGE is mapped to that frame without any
+ * I/O.  Otherwise a new frame is registered in FILE_FRAMES before it
+ * is filled, so that other mappings faulting on the same file page
+ * wait for it instead of reading it again.  A frame that is pinned
+ * is being filled or torn down; we yield until that settles.
+ * With EFILESYS the frame is the page cache frame of the file page,
+ * which read() and write() use as well.  A page entirely past the
+ * end of the file is not cached and gets a frame of its own. */
+static bool
+vm_claim_file_page(struct page *page, struct file_page *fp, bool may_evict)
+{
+	struct inode *inode = file_get_inode(fp->file);
+	off_t ofs = fp->ofs;
+	struct frame *frame = NULL, *shared;
+	bool ok;
+
+#ifdef EFILESYS
+	if (fp->read_bytes == 0)
+	{
+		frame = may_evict ? vm_get_frame() : vm_alloc_frame();
+		return frame != NULL && vm_install_frame(page, frame);
 	}
-	return false;
-	// if (!pte_found)
-	// 	return false;
 
-	// // & ~0xFFF 넣을지 고민
-	// *pte_found = vtop(frame->kva) & ~0xFFF;
+	shared = vm_cache_get(inode, ofs, may_evict);
+	if (shared == NULL)
+		return false;
+	lock_acquire(&frame_lock);
+	frame_link(shared, page);
+	ok = swap_in(page, shared->kva)
+		 && pml4_set_page(page->owner->pml4, page->va, shared->kva,
+						  page->writable);
+	if (ok)
+		file_share_cnt++;
+	else
+		frame_unlink(shared, page);
+	shared->io_pin_cnt--;
+	lock_release(&frame_lock);
+	return ok;
+#else
+	for (;;)
+	{
+		lock_acquire(&frame_lock);
+		shared = file_frame_find(inode_get_inumber(inode), ofs);
+		if (shared != NULL && !shared->pinned)
+		{
+			frame_link(shared, page);
+			ok = swap_in(page, shared->kva)
+				 && pml4_set_page(page->owner->pml4, page->va, shared->kva,
+								  page->writable);
+			if (ok)
+				file_share_cnt++;
+			else
+				frame_unlink(shared, page);
+			lock_release(&frame_lock);
+			if (frame != NULL)
+				vm_free_frame(frame);
+			return ok;
+		}
+		if (shared == NULL && frame != NULL)
+		{
+			frame->file_listed = true;
+			frame->file_inumber = inode_get_inumber(inode);
+			frame->file_ofs = ofs;
+			hash_insert(&file_frames, &frame->file_elem);
+			lock_release(&frame_lock);
+			return vm_install_frame(page, frame);
+		}
+		lock_release(&frame_lock);
+
+		if (shared != NULL)
+			thread_yield();
+		else
+		{
+			frame = may_evict ? vm_get_frame() : vm_alloc_frame();
+			if (frame == NULL)
+				return false;
+		}
+	}
+#endif
+}
+
+/* Returns the frame holding page OFS of the file whose inode number
+ * is INUMBER, or NULL.  FRAME_LOCK must be held. */
+static struct frame *
+file_frame_find(disk_sector_t inumber, off_t ofs)
+{
+	struct frame key;
+	struct hash_elem *e;
+
+	key.file_inumber = inumber;
+	key.file_ofs = ofs;
+	e = hash_find(&file_frames, &key.file_elem);
+	return e != NULL ? hash_entry(e, struct frame, file_elem) : NULL;
+}
+
+/* Removes FRAME from FILE_FRAMES if it is there.  FRAME_LOCK must be
+ * held. */
+static void
+file_frame_forget(struct frame *frame)
+{
+	if (!frame->file_listed)
+		return;
+	hash_delete(&file_frames, &frame->file_elem);
+	frame->file_listed = false;
+}
+
+/* Returns false if PAGE is the page cache page of its frame rather
+ * than a page some process maps. */
+static bool
+page_is_user(struct page *page UNUSED)
+{
+#ifdef EFILESYS
+	return page->operations->type != VM_PAGE_CACHE;
+#else
+	return true;
+#endif
+}
+
+#ifdef EFILESYS
+/* Page cache.
+ * page OFS의 page cache frame을 찾고, 없으면 새로 만들어 채운다.
+ * 채우는 동안은 frame이 pinned인 채로 FILE_FRAMES에 올라가 있어서
+ * 같은 page를 찾는 thread는 다 채워질 때까지 기다린다.  반환하는
+ * frame은 io_pin_cnt로 pin되어 있으므로 다 쓰면 vm_cache_put()을
+ * 불러야 한다.  frame이 없고 MAY_EVICT가 false이거나 읽지 못하면
+ * NULL을 반환한다. */
+struct frame *
+vm_cache_get(struct inode *inode, off_t ofs, bool may_evict)
+{
+	disk_sector_t inumber = inode_get_inumber(inode);
+	struct frame *frame = NULL, *cached;
+	struct page *page;
+
+	ASSERT(ofs % PGSIZE == 0);
+
+	for (;;)
+	{
+		lock_acquire(&frame_lock);
+		cached = file_frame_find(inumber, ofs);
+		if (cached != NULL && !cached->pinned)
+		{
+			cached->io_pin_cnt++;
+			lock_release(&frame_lock);
+			if (frame != NULL)
+				vm_free_frame(frame);
+			return cached;
+		}
+		if (cached == NULL && frame != NULL)
+		{
+			frame->file_listed = true;
+			frame->file_inumber = inumber;
+			frame->file_ofs = ofs;
+			hash_insert(&file_frames, &frame->file_elem);
+			lock_release(&frame_lock);
+			break;
+		}
+		lock_release(&frame_lock);
+
+		if (cached != NULL)
+			thread_yield();
+		else
+		{
+			frame = may_evict ? vm_get_frame() : vm_alloc_frame();
+			if (frame == NULL)
+				return NULL;
+		}
+	}
+
+	/* page cache page를 맨 앞에 붙여서 mapping이 모두 풀려도 frame이
+	 * 남게 한다.  frame이 pinned이므로 FRAME_LOCK 없이 붙여도 된다. */
+	page = page_cache_alloc(inode, ofs);
+	if (page != NULL)
+	{
+		frame_link(frame, page);
+		if (swap_in(page, frame->kva))
+		{
+			lock_acquire(&frame_lock);
+			frame->io_pin_cnt++;
+			frame->pinned = false;
+			lock_release(&frame_lock);
+			return frame;
+		}
+		frame_unlink(frame, page);
+		vm_dealloc_page(page);
+	}
+	vm_free_frame(frame);
+	return NULL;
+}
+
+/* Unpins FRAME, a frame returned by vm_cache_get(). */
+void vm_cache_put(struct frame *frame)
+{
+	lock_acquire(&frame_lock);
+	ASSERT(frame->io_pin_cnt > 0);
+	frame->io_pin_cnt--;
+	lock_release(&frame_lock);
+}
+
+/* Returns true if page OFS of INODE is in the page cache. */
+bool vm_cache_resident(struct inode *inode, off_t ofs)
+{
+	bool resident;
+
+	lock_acquire(&frame_lock);
+	resident = file_frame_find(inode_get_inumber(inode), ofs) != NULL;
+	lock_release(&frame_lock);
+	return resident;
+}
+
+/* Writes back every dirty page cache frame.
+ * FRAME_LOCK 아래에서 WRITEBACK_BATCH개씩 dirty한 frame을 골라
+ * io_pin_cnt로 pin하고, lock을 놓은 채 써 낸다.  pin한 frame은
+ * evict되거나 해제되지 않으므로 다음 묶음은 마지막 frame 다음부터
+ * 이어서 찾는다. */
+#define WRITEBACK_BATCH 16
+void vm_cache_writeback(void)
+{
+	struct frame *batch[WRITEBACK_BATCH];
+	struct list_elem *e;
+
+	lock_acquire(&frame_lock);
+	e = list_begin(&frame_list);
+	while (e != list_end(&frame_list))
+	{
+		size_t cnt = 0, i;
+
+		for (; e != list_end(&frame_list) && cnt < WRITEBACK_BATCH;
+			 e = list_next(e))
+		{
+			struct frame *f = list_entry(e, struct frame, f_elem);
+
+			if (!f->pinned && f->file_listed && cache_frame_dirty(f))
+			{
+				f->io_pin_cnt++;
+				batch[cnt++] = f;
+			}
+		}
+		if (cnt == 0)
+			break;
+		lock_release(&frame_lock);
+
+		for (i = 0; i < cnt; i++)
+			swap_out(batch[i]->page);
+
+		lock_acquire(&frame_lock);
+		e = list_next(&batch[cnt - 1]->f_elem);
+		for (i = 0; i < cnt; i++)
+			batch[i]->io_pin_cnt--;
+	}
+	lock_release(&frame_lock);
+}
+
+/* Discards the page cache pages of INODE without writing them back.
+ * Called when the last opener closes a removed file, before its
+ * sectors are freed, so no process maps it any more.  Frames still
+ * being filled, evicted or written back are waited for. */
+void vm_cache_drop(struct inode *inode)
+{
+	disk_sector_t inumber = inode_get_inumber(inode);
+	off_t length = inode_length(inode);
+	off_t ofs;
+
+	for (ofs = 0; ofs < length; ofs += PGSIZE)
+	{
+		struct frame *frame;
+		struct page *page;
+
+		lock_acquire(&frame_lock);
+		while ((frame = file_frame_find(inumber, ofs)) != NULL
+			   && (frame->pinned || frame->io_pin_cnt > 0))
+		{
+			lock_release(&frame_lock);
+			thread_yield();
+			lock_acquire(&frame_lock);
+		}
+		if (frame == NULL)
+		{
+			lock_release(&frame_lock);
+			continue;
+		}
+		ASSERT(frame->ref_cnt == 1);
+		page = frame->page;
+		frame->pinned = true;
+		file_frame_forget(frame);
+		frame_unlink(frame, page);
+		lock_release(&frame_lock);
+
+		page->page_cache.dirty = false;
+		vm_dealloc_page(page);
+		vm_free_frame(frame);
+	}
+}
+
+/* Returns true if FRAME, a page cache frame, holds data not yet
+ * written back.  The dirty bits of the pages mapping it are moved
+ * into its page cache page, so that the writeback that follows
+ * covers them.  FRAME_LOCK must be held or FRAME pinned. */
+static bool
+cache_frame_dirty(struct frame *frame)
+{
+	struct page *cache = frame->page;
+	struct list_elem *e;
+
+	ASSERT(!page_is_user(cache));
+
+	for (e = list_next(&cache->frame_elem); e != list_end(&frame->pages);
+		 e = list_next(e))
+	{
+		struct page *page = list_entry(e, struct page, frame_elem);
+		uint64_t *pml4 = page->owner->pml4;
+
+		if (pml4_is_dirty(pml4, page->va))
+		{
+			pml4_set_dirty(pml4, page->va, false);
+			cache->page_cache.dirty = true;
+		}
+	}
+	return cache->page_cache.dirty;
+}
+#endif
+
+/* Fills FRAME, a pinned frame not yet linked to any page, with
+ * PAGE's contents and maps it.  On failure FRAME is freed. */
+static bool
+vm_install_frame(struct page *page, struct frame *frame)
+{
+	/* Set links */
+	frame_link(frame, page);
 
-	// return true;
-	/* not yet 아직 구현 안함
-	return swap_in(page, frame->kva);
-	*/
+	/* 내용을 먼저 채운 뒤에 page의 VA를 frame의 PA로 맵핑한다.
+	 * 그동안 frame은 pinned 상태라 evict되지 않는다. */
+	if (!swap_in(page, frame->kva)
+		|| !pml4_set_page(page->owner->pml4, page->va, frame->kva, page->writable))
+	{
+		frame_unlink(frame, page);
+		vm_free_frame(frame);
+		return false;
+	}
+
+	frame->pinned = false;
+	return true;
 }
 
 /*  spt 초기화 함수
- initd, __do_fork에서 사용, 즉 프로세스가 새로 생성될 때 사용하기 때문에
- 테이블은 유저 영역에 할당한다.
+ initd, __do_fork에서 사용, 즉 프로세스가 새로 생성될 때 사용한다.
+ table은 처음 page를 넣을 때 만든다.
 */
 void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED)
 {
-	spt->spt_hash_table = palloc_get_page(PAL_USER);
-	hash_init(spt->spt_hash_table, page_hash, page_less, NULL);
+	spt->root = NULL;
+	spt->spt_hash_table = NULL;
+	list_init(&spt->mmaps);
 }
 
 /* Copy supplemental page table from src to dst */
+/* fork에서 자식(current)이 부모의 SPT를 복사한다.
+ * 메모리에 올라와 있는 page는 내용을 복사하지 않고 frame을 공유하며,
+ * 부모와 자식 모두 read-only로 맵핑해서 처음 쓰기가 일어날 때
+ * vm_handle_wp에서 복사한다.  zero frame에 맵핑된 page도 그대로
+ * 공유한다.  swap out된 page와 아직 초기화되지 않은(uninit) page는
+ * 올리지 않고 swap slot을 같이 가리키거나 aux를 복제해서 자식 쪽에서도
+ * lazy하게 둔다.  그 밖의 page는 먼저 부모 쪽으로 올린 뒤 공유한다. */
 bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 								  struct supplemental_page_table *src UNUSED)
 {
+	struct hash_iterator i;
+
+	if (src->spt_hash_table == NULL)
+		return src->root == NULL || spt_node_walk(src->root, 3, spt_copy_page, dst);
+
+	hash_first(&i, src->spt_hash_table);
+	while (hash_next(&i))
+		if (!spt_copy_page(hash_entry(hash_cur(&i), struct page, p_hash_elem), dst))
+			return false;
+	return true;
+}
+
+/* Shares SRC_PAGE, a page of the parent, with the child's SPT DST_. */
+static bool
+spt_copy_page(struct page *src_page, void *dst_)
+{
+	struct supplemental_page_table *dst = dst_;
+	struct thread *curr = thread_current();
+	struct page *dst_page;
+	struct frame *frame;
+
+	/* mmap은 자식에게 물려주지 않는다. */
+	if (page_get_type(src_page) == VM_FILE)
+		return true;
+
+	dst_page = malloc(sizeof *dst_page);
+	if (dst_page == NULL)
+		return false;
+
+	/* page 구조체는 FRAME_LOCK 안에서 복사해야 eviction 도중의
+	 * 반쯤 바뀐 상태(swap slot 등)를 보지 않는다.  올려서 공유해야 하는
+	 * page가 그 사이에 또 evict되었으면 한 번 더 올린다. */
+	for (;;)
+	{
+		lock_acquire(&frame_lock);
+		page_frame_wait(src_page);
+		if (src_page->frame != NULL)
+			break;
+		if (spt_copy_unloaded(src_page, dst_page))
+		{
+			lock_release(&frame_lock);
+			goto insert;
+		}
+		lock_release(&frame_lock);
+		if (!vm_do_claim_page(src_page))
+		{
+			free(dst_page);
+			return false;
+		}
+	}
+
+	*dst_page = *src_page;
+	dst_page->owner = curr;
+	dst_page->frame = NULL;
+	frame = src_page->frame;
+	frame_link(frame, dst_page);
+	if (src_page->writable)
+		vm_remap(src_page, frame->kva, false);
+	if (!pml4_set_page(curr->pml4, dst_page->va, frame->kva, false))
+	{
+		frame_unlink(frame, dst_page);
+		lock_release(&frame_lock);
+		free(dst_page);
+		return false;
+	}
+	cow_share_cnt++;
+	lock_release(&frame_lock);
+
+insert:
+	if (!spt_insert_page(dst, dst_page))
+	{
+		spt_destroy_page(dst_page);
+		return false;
+	}
+	return true;
+}
+
+/* Sets DST up as a copy of SRC, a page of the parent with no frame,
+ * without loading SRC: a swapped-out anonymous page shares its swap
+ * slot, a page still to be read from the executable gets its own aux
+ * pointing at the child's running_file, and a page that starts out
+ * zeroed stays that way, so that the child can map it to the zero
+ * frame too.  Returns false if SRC has
+ * to be loaded and shared instead.  FRAME_LOCK must be held. */
+static bool
+spt_copy_unloaded(struct page *src, struct page *dst)
+{
+	struct thread *curr = thread_current();
+	struct file_page *aux;
+
+	if (src->operations->type == VM_ANON)
+	{
+		if (src->anon.swap_slot == SWAP_SLOT_NONE)
+			return false;
+		*dst = *src;
+		anon_share_slot(dst, src);
+	}
+	else if (src->operations->type == VM_UNINIT)
+	{
+		aux = NULL;
+		if (src->uninit.aux != NULL)
+		{
+			if (!(src->uninit.type & VM_FILE_INIT))
+				return false;
+			aux = malloc(sizeof *aux);
+			if (aux == NULL)
+				return false;
+			*aux = *(struct file_page *)src->uninit.aux;
+			aux->file = curr->running_file;
+		}
+		*dst = *src;
+		dst->uninit.aux = aux;
+	}
+	else
+		return false;
+
+	dst->owner = curr;
+	dst->frame = NULL;
+	cow_lazy_cnt++;
+	return true;
+}
+
+/* hash_clear에 넘기는 destructor: page와 frame을 함께 해제한다. */
+static void
+spt_destructor(struct hash_elem *e, void *aux UNUSED)
+{
+	spt_destroy_page(hash_entry(e, struct page, p_hash_elem));
 }
 
 /* Free the resource hold by the supplemental page table */
+/* exec에서도 불리므로 table까지 해제하고, 다음에 page를 넣을 때 다시
+ * 만든다.  page를 한 번도 넣지 않았으면(SPT를 쓰지 않는 kernel thread
+ * 포함) 할 일이 없다. */
 void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED)
 {
 	/* TODO: Destroy all the supplemental_page_table hold by thread and
 	 * TODO: writeback all the modified contents to the storage. */
+	if (spt->root == NULL && spt->spt_hash_table == NULL)
+		return;
+	/* mmap된 page는 region 단위로 되쓰고 파일을 닫는다. */
+	do_munmap_all();
+	if (spt->root != NULL)
+	{
+		spt_node_clear(spt->root, 3);
+		spt->root = NULL;
+	}
+	if (spt->spt_hash_table != NULL)
+	{
+		hash_destroy(spt->spt_hash_table, spt_destructor);
+		free(spt->spt_hash_table);
+		spt->spt_hash_table = NULL;
+	}
 }
 
 /* hash table로 만들어진 spt에서 사용할 hash 함수 */
-unsigned
+static uint64_t
 page_hash(const struct hash_elem *p_elem, void *aux UNUSED)
 {
 	const struct page *p = hash_entry(p_elem, struct page, p_hash_elem);
@@ -274,11 +1914,48 @@ page_hash(const struct hash_elem *p_elem, void *aux UNUSED)
 }
 
 /* hash table로 만들어진 spt에서 사용할 hash_comarison 함수 */
-bool page_less(const struct hash_elem *p_elem_a,
-			   const struct hash_elem *p_elem_b, void *aux UNUSED)
+static bool
+page_less(const struct hash_elem *p_elem_a,
+		  const struct hash_elem *p_elem_b, void *aux UNUSED)
 {
 	const struct page *a = hash_entry(p_elem_a, struct page, p_hash_elem);
 	const struct page *b = hash_entry(p_elem_b, struct page, p_hash_elem);
 
 	return a->va < b->va;
-}
\ No newline at end of file
+}
+
+/* FILE_FRAMES에서 사용할 hash 함수 */
+static uint64_t
+file_frame_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	const struct frame *f = hash_entry(e, struct frame, file_elem);
+	return hash_int(f->file_inumber) ^ hash_int(f->file_ofs);
+}
+
+/* FILE_FRAMES에서 사용할 hash_comarison 함수 */
+static bool
+file_frame_less(const struct hash_elem *a_, const struct hash_elem *b_,
+				void *aux UNUSED)
+{
+	const struct frame *a = hash_entry(a_, struct frame, file_elem);
+	const struct frame *b = hash_entry(b_, struct frame, file_elem);
+
+	if (a->file_inumber != b->file_inumber)
+		return a->file_inumber < b->file_inumber;
+	return a->file_ofs < b->file_ofs;
+}
+
+/* KSM_TABLE에서 사용할 hash 함수: 내용의 checksum을 그대로 쓴다. */
+static uint64_t
+ksm_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	return hash_entry(e, struct frame, ksm_elem)->ksm_sum;
+}
+
+/* KSM_TABLE에서 사용할 hash_comarison 함수 */
+static bool
+ksm_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
+{
+	return hash_entry(a, struct frame, ksm_elem)->ksm_sum
+		   < hash_entry(b, struct frame, ksm_elem)->ksm_sum;
+}